@@ -0,0 +1,205 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include <cstdlib>
+#include <limits>
+#include <vector>
+
+namespace grid_map_transforms{
+
+  /*
+   * Clearance rays: is every cell on the line from start to end (end
+   * excluded) at least required_clearance away from obstacles? Cells are
+   * those of grid_map::LineIterator (Bresenham on the unwrapped map), but
+   * the walk steps through the memory of a distance layer with integer
+   * offsets instead of building iterators and indices. Works on float
+   * layers and quantized fields (any column major Eigen matrix laid out
+   * like the layers of the map) and on circular buffers, buffer_start_index
+   * being GridMap::getStartIndex(). Indices are buffer indices. With
+   * require_value, cells without distance (max, e.g. not reached by the
+   * distance transform) block the line as well.
+   */
+  struct ClearanceRay
+  {
+    // Offset of the current cell, cells left to check (end excluded)
+    int offset;
+    int num_checks;
+
+    // Bresenham state, steps are memory offsets
+    int major_delta;
+    int minor_delta;
+    int numerator;
+    int major_step;
+    int minor_step;
+
+    // True if the line crosses the edge of a circular buffer, steps then
+    // are not constant offsets but taken per axis
+    bool wraps;
+    bool x_major;
+    int step_x;
+    int step_y;
+  };
+
+  inline int wrapClearanceIndex(const int index, const int size)
+  {
+    return (index >= size) ? (index - size) : ((index < 0) ? (index + size) : index);
+  }
+
+  /*
+   * Sets up ray for the line from start to end on a buffer of size_x by
+   * size_y cells.
+   */
+  inline void initClearanceRay(const int size_x,
+                               const int size_y,
+                               const grid_map::Index& buffer_start_index,
+                               const grid_map::Index& start,
+                               const grid_map::Index& end,
+                               ClearanceRay& ray)
+  {
+    // Unwrapped coordinates give the line, buffer ones the memory
+    const int start_x = wrapClearanceIndex(start(0) - buffer_start_index(0), size_x);
+    const int start_y = wrapClearanceIndex(start(1) - buffer_start_index(1), size_y);
+    const int delta_x = wrapClearanceIndex(end(0) - buffer_start_index(0), size_x) - start_x;
+    const int delta_y = wrapClearanceIndex(end(1) - buffer_start_index(1), size_y) - start_y;
+
+    ray.step_x = (delta_x >= 0) ? 1 : -1;
+    ray.step_y = (delta_y >= 0) ? 1 : -1;
+
+    // The buffer is contiguous along the line if no unwrapped coordinate
+    // on it maps past the buffer edge
+    ray.wraps = ((start(0) + delta_x) != end(0)) || ((start(1) + delta_y) != end(1));
+
+    ray.offset = start(0) + start(1) * size_x;
+
+    ray.x_major = std::abs(delta_x) >= std::abs(delta_y);
+
+    if (ray.x_major){
+      ray.major_delta = std::abs(delta_x);
+      ray.minor_delta = std::abs(delta_y);
+      ray.major_step = ray.step_x;
+      ray.minor_step = ray.step_y * size_x;
+    }else{
+      ray.major_delta = std::abs(delta_y);
+      ray.minor_delta = std::abs(delta_x);
+      ray.major_step = ray.step_y * size_x;
+      ray.minor_step = ray.step_x;
+    }
+
+    ray.numerator = ray.major_delta / 2;
+    ray.num_checks = ray.major_delta;
+  }
+
+  /*
+   * Advances ray by one cell. On wrapping rays, offsets are recomputed from
+   * the buffer coordinates.
+   */
+  inline void stepClearanceRay(const int size_x,
+                               const int size_y,
+                               ClearanceRay& ray)
+  {
+    bool minor = false;
+
+    ray.numerator += ray.minor_delta;
+
+    if (ray.numerator >= ray.major_delta){
+      ray.numerator -= ray.major_delta;
+      minor = true;
+    }
+
+    --ray.num_checks;
+
+    if (!ray.wraps){
+      ray.offset += minor ? (ray.major_step + ray.minor_step) : ray.major_step;
+      return;
+    }
+
+    const int step_x = (ray.x_major || minor) ? ray.step_x : 0;
+    const int step_y = (!ray.x_major || minor) ? ray.step_y : 0;
+
+    ray.offset = wrapClearanceIndex(ray.offset % size_x + step_x, size_x) +
+                 wrapClearanceIndex(ray.offset / size_x + step_y, size_y) * size_x;
+  }
+
+  template <class Data>
+  inline bool isRayClear(const Data& dist_data,
+                         const grid_map::Index& buffer_start_index,
+                         const grid_map::Index& start,
+                         const grid_map::Index& end,
+                         const typename Data::Scalar required_clearance,
+                         const bool require_value = false)
+  {
+    typedef typename Data::Scalar Scalar;
+
+    const int size_x = dist_data.rows();
+    const int size_y = dist_data.cols();
+    const Scalar* dist = dist_data.data();
+
+    const Scalar no_value = std::numeric_limits<Scalar>::max();
+
+    ClearanceRay ray;
+    initClearanceRay(size_x, size_y, buffer_start_index, start, end, ray);
+
+    if (!ray.wraps){
+      int offset = ray.offset;
+      int numerator = ray.numerator;
+
+      for (int i = 0; i < ray.num_checks; ++i){
+        if ((dist[offset] < required_clearance) || (require_value && (dist[offset] == no_value)))
+          return false;
+
+        numerator += ray.minor_delta;
+        offset += ray.major_step;
+
+        if (numerator >= ray.major_delta){
+          numerator -= ray.major_delta;
+          offset += ray.minor_step;
+        }
+      }
+
+      return true;
+    }
+
+    while (ray.num_checks > 0){
+      if ((dist[ray.offset] < required_clearance) || (require_value && (dist[ray.offset] == no_value)))
+        return false;
+
+      stepClearanceRay(size_x, size_y, ray);
+    }
+
+    return true;
+  }
+
+  /*
+   * isRayClear for many lines from one start, e.g. the candidates of a
+   * shortcut or line of sight search. The start cell is checked once for
+   * all rays. Rays are walked one after another: the reads of one ray do
+   * not depend on each other and already overlap, walking rays in lockstep
+   * was slower. clear[i] is 1 if the line to ends[i] is clear.
+   */
+  template <class Data>
+  inline void areRaysClear(const Data& dist_data,
+                           const grid_map::Index& buffer_start_index,
+                           const grid_map::Index& start,
+                           const std::vector<grid_map::Index>& ends,
+                           const typename Data::Scalar required_clearance,
+                           std::vector<unsigned char>& clear,
+                           const bool require_value = false)
+  {
+    const typename Data::Scalar start_dist = dist_data(start(0), start(1));
+    const bool start_clear = !(start_dist < required_clearance) &&
+                             !(require_value && (start_dist == std::numeric_limits<typename Data::Scalar>::max()));
+
+    clear.resize(ends.size());
+
+    for (size_t i = 0; i < ends.size(); ++i){
+      if ((ends[i](0) == start(0)) && (ends[i](1) == start(1))){
+        clear[i] = 1;
+      }else{
+        clear[i] = start_clear && isRayClear(dist_data, buffer_start_index, start, ends[i], required_clearance, require_value);
+      }
+    }
+  }
+
+} /* namespace */
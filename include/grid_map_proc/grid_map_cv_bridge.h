@@ -0,0 +1,40 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include <opencv2/core/core.hpp>
+
+namespace grid_map_cv_bridge{
+
+  /*
+   * Wraps the storage of a grid map layer as a CV_32FC1 cv::Mat without
+   * copying. Eigen stores column-major, so the view is transposed: Mat rows
+   * correspond to y and Mat columns to x. The view is only valid as long as
+   * the layer is not reallocated.
+   */
+  cv::Mat getTransposedView(grid_map::Matrix& data);
+
+  /*
+   * Read only variant, the returned Mat must not be written to.
+   */
+  cv::Mat getTransposedView(const grid_map::Matrix& data);
+
+  /*
+   * Computes a CV_8UC1 mask (255 where the comparison holds, 0 otherwise)
+   * with the same transposed layout as getTransposedView. cmp_op is one of
+   * the cv::CMP_* constants.
+   */
+  void getComparisonMask(const grid_map::Matrix& data,
+                         const float value,
+                         const int cmp_op,
+                         cv::Mat& mask);
+
+  /*
+   * Adds a layer or reuses the storage of an existing one of the right size
+   * so views created afterwards stay valid while it is written.
+   */
+  grid_map::Matrix& getOrAddLayer(grid_map::GridMap& grid_map,
+                                  const std::string& layer);
+
+} /* namespace */
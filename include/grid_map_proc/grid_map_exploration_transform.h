@@ -0,0 +1,106 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include <grid_map_proc/grid_map_transforms.h>
+
+// Eigen
+#include <Eigen/Core>
+
+#include <queue>
+
+namespace grid_map_transforms{
+
+  /*
+   * Persistent exploration transform that keeps its state between calls and
+   * only repairs the inconsistent region after goals were added or removed or
+   * occupancy/distance cells changed (LPA* without heuristic, searching from
+   * all goals at once). The resulting layer equals the one written by
+   * addExplorationTransform for the same inputs.
+   */
+  class IncrementalExplorationTransform
+  {
+  public:
+    IncrementalExplorationTransform(const float lethal_dist = 6.0,
+                                    const float penalty_dist = 12.0,
+                                    const std::string occupancy_layer = "occupancy",
+                                    const std::string dist_trans_layer = "distance_transform",
+                                    const std::string expl_trans_layer = "exploration_transform");
+
+    void setGoals(const std::vector<grid_map::Index>& goal_points);
+    void addGoal(const grid_map::Index& goal_point);
+    void removeGoal(const grid_map::Index& goal_point);
+
+    /*
+     * Cells whose occupancy or distance transform value changed since the
+     * last update, for instance as reported by updateDistanceTransform.
+     */
+    void markCellsChanged(const std::vector<grid_map::Index>& changed_cells);
+
+    // Forces a full recomputation on the next update.
+    void reset();
+
+    /*
+     * Repairs the transform and writes changed values to the exploration
+     * transform layer. Falls back to a full computation on the first call,
+     * after reset() or if the map size changed.
+     */
+    bool update(grid_map::GridMap& grid_map);
+
+    // Cells expanded by the last update.
+    size_t getNumExpandedCells() const { return num_expanded_cells_; }
+
+  protected:
+    typedef std::pair<float, int> QueueEntry;
+
+    void initialize(const grid_map::Size& size);
+
+    void updateCell(const OccupancyCodes& occupancy_codes,
+                    const grid_map::Matrix& dist_data,
+                    const int idx_x,
+                    const int idx_y);
+
+    void updateNeighbors(const OccupancyCodes& occupancy_codes,
+                         const grid_map::Matrix& dist_data,
+                         const int idx_x,
+                         const int idx_y);
+
+    void lowerNeighbors(const OccupancyCodes& occupancy_codes,
+                        const grid_map::Matrix& dist_data,
+                        const int idx_x,
+                        const int idx_y);
+
+    void computeTransform(const OccupancyCodes& occupancy_codes,
+                          const grid_map::Matrix& dist_data);
+
+    float lethal_dist_;
+    float penalty_dist_;
+
+    std::string occupancy_layer_;
+    std::string dist_trans_layer_;
+    std::string expl_trans_layer_;
+
+    grid_map::Size size_;
+    bool needs_reset_;
+
+    // Current and one-step lookahead values
+    grid_map::Matrix g_;
+    grid_map::Matrix rhs_;
+
+    std::vector<grid_map::Index> goals_;
+    std::vector<grid_map::Index> applied_goals_;
+    std::vector<char> goal_mask_;
+
+    // Kept alongside the occupancy layer, refreshed at pending cells
+    OccupancyCodes occupancy_codes_;
+
+    std::vector<grid_map::Index> pending_cells_;
+    std::vector<int> changed_cells_;
+
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue_;
+
+    size_t num_expanded_cells_;
+  };
+
+} /* namespace */
@@ -0,0 +1,178 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include <list>
+
+namespace grid_map_transforms{
+
+  /*
+   * Map sized array in TiledLayout order backed by a memory mapped file, so
+   * maps larger than main memory can be processed. Tiles are page aligned
+   * (4 KB of bytes, 16 KB of floats), releaseTile drops a tile from the
+   * resident set while its contents stay in the file.
+   */
+  class MappedTileFile
+  {
+  public:
+    MappedTileFile();
+    ~MappedTileFile();
+
+    const TiledLayout& layout() const { return layout_; }
+    bool isOpen() const { return data_ != 0; }
+
+    void releaseTile(const int tile) const;
+    void releaseAll() const;
+
+    void close();
+
+  protected:
+    bool map(const std::string& file_name,
+             const int size_x,
+             const int size_y,
+             const size_t cell_bytes,
+             const bool create);
+
+    TiledLayout layout_;
+    size_t cell_bytes_;
+    size_t num_bytes_;
+    void* data_;
+    int fd_;
+
+  private:
+    MappedTileFile(const MappedTileFile&);
+    MappedTileFile& operator=(const MappedTileFile&);
+  };
+
+  template <class Scalar>
+  class MappedTiledGrid : public MappedTileFile
+  {
+  public:
+    /*
+     * Creates or truncates file_name for a size_x by size_y map with all
+     * cells (including tile padding) set to fill_value.
+     */
+    bool create(const std::string& file_name,
+                const int size_x,
+                const int size_y,
+                const Scalar fill_value = Scalar(0))
+    {
+      if (!map(file_name, size_x, size_y, sizeof(Scalar), true))
+        return false;
+
+      // New files read as zero, other values are written tile by tile
+      if (fill_value != Scalar(0)){
+        for (int tile = 0; tile < layout_.numTiles(); ++tile){
+          Scalar* tile_data = data() + static_cast<size_t>(tile) * TiledLayout::TILE_CELLS;
+          std::fill(tile_data, tile_data + TiledLayout::TILE_CELLS, fill_value);
+          releaseTile(tile);
+        }
+      }
+
+      return true;
+    }
+
+    // Maps a file written by create for a map of the same size
+    bool open(const std::string& file_name,
+              const int size_x,
+              const int size_y)
+    {
+      return map(file_name, size_x, size_y, sizeof(Scalar), false);
+    }
+
+    Scalar* data() const { return static_cast<Scalar*>(data_); }
+
+    Scalar& at(const int idx_x, const int idx_y) const { return data()[layout_.index(idx_x, idx_y)]; }
+  };
+
+  /*
+   * Tiles touched by an out of core search, least recently used ones are
+   * released from all grids once more than max_resident_tiles are resident.
+   * Grids are released entirely every max_resident_tiles evictions, which
+   * also drops pages the kernel mapped around faulting ones.
+   */
+  class ResidentTiles
+  {
+  public:
+    ResidentTiles(const int num_tiles,
+                  const int max_resident_tiles);
+
+    void addGrid(const MappedTileFile& grid) { grids_.push_back(&grid); }
+
+    /*
+     * Marks tile as most recently used. current_tile is the tile being
+     * processed, it stays tracked when all tiles are released.
+     */
+    void touch(const int tile,
+               const int current_tile = -1);
+
+    // Releases all tiles, e.g. at the end of a stage
+    void releaseAll();
+
+  protected:
+    size_t max_resident_tiles_;
+    size_t num_evicted_;
+    std::vector<const MappedTileFile*> grids_;
+    std::list<int> lru_;
+    std::vector<std::list<int>::iterator> positions_;
+    std::vector<unsigned char> resident_;
+  };
+
+  /*
+   * Streams a float layer into grid tile by tile, and back. grid must have
+   * been created for the size of the layer. The grid is in map order:
+   * start_index is the buffer start index of the layer
+   * (GridMap::getStartIndex), so layers of moved maps are unwrapped on
+   * import and wrapped again on export. Indices passed to the mapped
+   * transforms are unwrapped (grid_map::getIndexFromBufferIndex).
+   */
+  bool importMappedLayer(const grid_map::Matrix& layer,
+                         const grid_map::Index& start_index,
+                         MappedTiledGrid<float>& grid);
+
+  bool exportMappedLayer(const MappedTiledGrid<float>& grid,
+                         const grid_map::Index& start_index,
+                         grid_map::Matrix& layer);
+
+  /*
+   * Occupancy codes (see buildOccupancyCodes) of a tiled float occupancy
+   * grid, streamed tile by tile. Tile padding is marked unknown border, so
+   * searches never enter it.
+   */
+  bool buildMappedOccupancyCodes(const MappedTiledGrid<float>& occupancy,
+                                 MappedTiledGrid<unsigned char>& occupancy_codes);
+
+  /*
+   * Out of core addDistanceTransform. The searches run tile by tile:
+   * improvements of cells in another tile are queued with that tile, and
+   * the tile with the lowest queued value is processed next, so at most
+   * max_resident_tiles tiles of each grid are resident at any time.
+   * Reachability is kept in cell_state (one byte per cell, replaces the
+   * dist_seed_transform layer). All grids must have the same size, values
+   * equal those of addDistanceTransform.
+   */
+  bool computeDistanceTransformMapped(const MappedTiledGrid<unsigned char>& occupancy_codes,
+                                      const grid_map::Index& seed_point,
+                                      std::vector<grid_map::Index>& obstacle_cells,
+                                      std::vector<grid_map::Index>& frontier_cells,
+                                      MappedTiledGrid<unsigned char>& cell_state,
+                                      MappedTiledGrid<float>& dist_trans,
+                                      const int max_resident_tiles = 1024);
+
+  /*
+   * Out of core addExplorationTransform, streamed like
+   * computeDistanceTransformMapped.
+   */
+  bool computeExplorationTransformMapped(const MappedTiledGrid<unsigned char>& occupancy_codes,
+                                         const MappedTiledGrid<float>& dist_trans,
+                                         const std::vector<grid_map::Index>& goal_points,
+                                         MappedTiledGrid<float>& expl_trans,
+                                         const float lethal_dist = 6.0,
+                                         const float penalty_dist = 12.0,
+                                         const int max_resident_tiles = 1024,
+                                         ExplorationTransformStats* stats = 0);
+
+} /* namespace */
@@ -12,9 +12,12 @@
 #include <queue>
 #include <nav_msgs/Path.h>
 
+#include <grid_map_proc/grid_map_transforms.h>
+#include <grid_map_proc/grid_map_clearance.h>
+
 namespace grid_map_path_planning{
 
-    bool findPathExplorationTransform(grid_map::GridMap& grid_map,
+    bool findPathExplorationTransform(const grid_map::GridMap& grid_map,
                             const geometry_msgs::Pose& start_pose,
                             std::vector<geometry_msgs::PoseStamped>& path,
                             float* path_cost = 0,
@@ -22,6 +25,114 @@ namespace grid_map_path_planning{
                             const std::string dist_trans_layer = "distance_transform",
                             const std::string expl_trans_layer = "exploration_transform");
 
+    /*
+     * findPathExplorationTransform on quantized fields (see
+     * computeExplorationTransformQuantized), the descent compares integers.
+     * Both fields must have the size of grid_map.
+     */
+    bool findPathExplorationTransform(const grid_map::GridMap& grid_map,
+                            const grid_map_transforms::QuantizedField& expl_field,
+                            const grid_map_transforms::QuantizedField& dist_field,
+                            const geometry_msgs::Pose& start_pose,
+                            std::vector<geometry_msgs::PoseStamped>& path,
+                            float* path_cost = 0);
+
+    /*
+     * findPathExplorationTransform for many start poses, e.g. candidate
+     * poses or robots, on num_threads threads sharing the read only map.
+     * The threads are those of the parallel transforms, started once and
+     * kept between calls.
+     * path_costs[i] is the cost from start_poses[i], max if there is no path
+     * from it. Paths are only extracted if paths is given, then paths[i] is
+     * empty where there is none, otherwise only the start cells are read.
+     * Returns false if a layer is missing.
+     */
+    bool findPathsExplorationTransform(const grid_map::GridMap& grid_map,
+                            const std::vector<geometry_msgs::Pose>& start_poses,
+                            std::vector<float>& path_costs,
+                            std::vector<std::vector<geometry_msgs::PoseStamped> >* paths = 0,
+                            const int num_threads = 1,
+                            const std::string dist_trans_layer = "distance_transform",
+                            const std::string expl_trans_layer = "exploration_transform");
+
+    /*
+     * Continuous descent of the bilinearly interpolated exploration
+     * transform from the start position, so the path is not bound to cell
+     * centers and needs no shortcutting. Waypoints are step_length map
+     * cells apart, the last one is the goal cell. Close to obstacles and
+     * unreached cells the descent falls back to cell steps.
+     */
+    bool findPathExplorationTransformInterpolated(const grid_map::GridMap& grid_map,
+                            const geometry_msgs::Pose& start_pose,
+                            std::vector<geometry_msgs::PoseStamped>& path,
+                            const float step_length = 5.0,
+                            float* path_cost = 0,
+                            const std::string expl_trans_layer = "exploration_transform");
+
+    /*
+     * Search state of findPathThetaStar, kept between queries. A cell's cost
+     * and parent are only valid if it was visited in the current generation,
+     * and it is only closed if it was closed in it. A query thus touches the
+     * cells it expands instead of resetting the map, only a change of map
+     * size reallocates.
+     */
+    struct ThetaStarWorkspace
+    {
+      // Open list entry, lowest estimate first
+      struct Node
+      {
+        float estimate;
+        int cell;
+
+        bool operator>(const Node& other) const { return estimate > other.estimate; }
+      };
+
+      ThetaStarWorkspace()
+        : generation(0)
+      {}
+
+      std::vector<float> cost_from_start;
+      std::vector<int> parents;
+      std::vector<unsigned int> visited;
+      std::vector<unsigned int> closed;
+      unsigned int generation;
+
+      // Heap of open cells, buffer rows and columns of unwrapped ones
+      std::vector<Node> open_cells;
+      std::vector<int> buffer_x;
+      std::vector<int> buffer_y;
+    };
+
+    /*
+     * Any angle (Theta*) path from start_pose to goal_pose on the distance
+     * transform, with the cost model of addExplorationTransform: cells
+     * closer than lethal_dist to obstacles are blocked, cells closer than
+     * penalty_dist add the squared difference. A cell takes the parent of
+     * the cell it is reached from if the straight line between them keeps
+     * penalty_dist (checked once, when the cell is expanded), so paths are
+     * close to shortest and need no shortcutting. The search is guided to
+     * the goal and expands far fewer cells than an exploration transform
+     * of the map, unless the goal is unreachable. Pass the same workspace
+     * to repeated queries, without one each call allocates state for every
+     * map cell.
+     */
+    bool findPathThetaStar(const grid_map::GridMap& grid_map,
+                           const geometry_msgs::Pose& start_pose,
+                           const geometry_msgs::Pose& goal_pose,
+                           std::vector<geometry_msgs::PoseStamped>& path,
+                           float* path_cost = 0,
+                           const float lethal_dist = 6.0,
+                           const float penalty_dist = 12.0,
+                           const std::string dist_trans_layer = "distance_transform",
+                           grid_map_transforms::ExplorationTransformStats* stats = 0,
+                           ThetaStarWorkspace* workspace = 0);
+
+    /*
+     * Moves a start pose the exploration transform does not reach to a close
+     * cell with clearance (findValidClosePoseExplorationTransform). False if
+     * the pose is outside the map or no such cell is found, revised_start_pose
+     * is not set then.
+     */
     bool adjustStartPoseIfOccupied(const grid_map::GridMap& grid_map,
                                    const geometry_msgs::Pose& start_pose,
                                    geometry_msgs::Pose& revised_start_pose,
@@ -31,6 +142,16 @@ namespace grid_map_path_planning{
 
 
 
+    /*
+     * Cell close to start_index with clearance to obstacles, e.g. to move
+     * the start of a robot that touched one. Best first search of the cells
+     * with the highest distance transform value within
+     * allowed_distance_from_start (map cells) of the start, never through
+     * obstacles, until a cell reaches desired_final_distance or
+     * max_expanded_cells cells were expanded. adjusted_index is the best
+     * cell found, false if it does not reach required_final_distance (then
+     * adjusted_index is start_index).
+     */
     bool findValidClosePoseExplorationTransform(const grid_map::GridMap& grid_map,
                             const grid_map::Index& start_index,
                             grid_map::Index& adjusted_index,
@@ -39,16 +160,28 @@ namespace grid_map_path_planning{
                             const float desired_final_distance = 12.0,
                             const std::string occupancy_layer = "occupancy",
                             const std::string dist_trans_layer = "distance_transform",
-                            const std::string expl_trans_layer = "exploration_transform");
-
-    bool shortCutPath(grid_map::GridMap& grid_map,
+                            const std::string expl_trans_layer = "exploration_transform",
+                            const int max_expanded_cells = 1024);
+
+    /*
+     * Removes path cells that can be skipped on a straight line keeping
+     * clearance (in map cells) to obstacles.
+     */
+    bool shortCutPath(const grid_map::GridMap& grid_map,
                       const std::vector <grid_map::Index>& path_in,
                       std::vector <grid_map::Index>& path_out,
                       const std::string dist_trans_layer = "distance_transform",
-                      const std::string expl_trans_layer = "exploration_transform");
+                      const std::string expl_trans_layer = "exploration_transform",
+                      const float clearance = 11.0);
+
+    bool shortCutPath(const grid_map::GridMap& grid_map,
+                      const grid_map_transforms::QuantizedField& dist_field,
+                      const std::vector <grid_map::Index>& path_in,
+                      std::vector <grid_map::Index>& path_out,
+                      const float clearance = 11.0);
 
 
-    void touchDistanceField(const grid_map::Matrix& dist_trans_map,
+    inline void touchDistanceField(const grid_map::Matrix& dist_trans_map,
                          const grid_map::Index& current_point,
                          const int idx_x,
                          const int idx_y,
@@ -69,7 +202,7 @@ namespace grid_map_path_planning{
 
 
 
-    void touchGradientCell(const grid_map::Matrix& expl_trans_map,
+    inline void touchGradientCell(const grid_map::Matrix& expl_trans_map,
                          const grid_map::Index& current_point,
                          const int idx_x,
                          const int idx_y,
@@ -91,25 +224,13 @@ namespace grid_map_path_planning{
       }
     }
 
-    bool shortCutValid(const grid_map::GridMap& grid_map,
+    inline bool shortCutValid(const grid_map::GridMap& grid_map,
                       const grid_map::Matrix& dist_trans_map,
                       const grid_map::Index& start_point,
-                      const grid_map::Index& end_point)
+                      const grid_map::Index& end_point,
+                      const float clearance = 11.0)
     {
-
-      for (grid_map::LineIterator iterator (grid_map, start_point, end_point);
-           !iterator.isPastEnd(); ++iterator) {
-
-         const grid_map::Index index(*iterator);
-
-         if ( (dist_trans_map(index(0), index(1)) < 11.0) &&
-              !( (index(0) == end_point(0)) && (index(1) == end_point(1))) ){
-           return false;
-         }
-
-      }
-      return true;
-
+      return grid_map_transforms::isRayClear(dist_trans_map, grid_map.getStartIndex(), start_point, end_point, clearance);
     }
 
 } /* namespace */
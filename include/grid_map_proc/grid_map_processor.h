@@ -0,0 +1,103 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+#include <grid_map_msgs/GridMap.h>
+
+#include <ros/ros.h>
+
+#include <geometry_msgs/PoseStamped.h>
+#include <nav_msgs/OccupancyGrid.h>
+#include <tf/transform_listener.h>
+
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace grid_map_proc{
+
+  /*
+   * Runs the reachability, distance and exploration transforms on incoming
+   * grid maps or occupancy grids on a worker thread. Only the latest input
+   * waits for the worker, older ones are dropped. Reachability is seeded at
+   * the robot, an input that arrives before its pose is available is
+   * retried until a newer one replaces it. Results go to one of two maps,
+   * the other one stays available to planning queries until the buffers
+   * are swapped.
+   *
+   * With a positive inflation_radius, an occupancy_inflated layer is added
+   * after the transforms. It is an output for other consumers only, the
+   * transforms and path planning use the plain occupancy layer and the
+   * lethal_dist and penalty_dist margins.
+   *
+   * Paths are found with findPathExplorationTransform, or with
+   * findPathExplorationTransformInterpolated (steps of path_step_length
+   * cells) when the planner parameter is "interpolated".
+   *
+   * Subscribed: grid_map (grid_map_msgs/GridMap), map (nav_msgs/OccupancyGrid),
+   * start_pose (geometry_msgs/PoseStamped, plans a path on the latest map).
+   * Published: grid_map_out (grid_map_msgs/GridMap), path (nav_msgs/Path).
+   */
+  class GridMapProcessor
+  {
+  public:
+    GridMapProcessor(ros::NodeHandle& nh,
+                     ros::NodeHandle& pnh);
+    ~GridMapProcessor();
+
+    // Latest processed map, null before the first one. Never waits for processing.
+    std::shared_ptr<const grid_map::GridMap> getLatestMap() const;
+
+    size_t getNumDroppedInputs() const;
+
+  protected:
+    void gridMapCallback(const grid_map_msgs::GridMapConstPtr& msg);
+    void occupancyGridCallback(const nav_msgs::OccupancyGridConstPtr& msg);
+    void startPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg);
+
+    void processLoop();
+    bool lookupRobotPosition(const std::string& map_frame,
+                             grid_map::Position& robot_position);
+    bool processMap(grid_map::GridMap& grid_map,
+                    const grid_map::Position& robot_position);
+    void swapBuffers();
+
+    std::string occupancy_layer_;
+    std::string robot_frame_;
+    std::string planner_;
+    float lethal_dist_;
+    float penalty_dist_;
+    float inflation_radius_;
+    float path_step_length_;
+    double transform_timeout_;
+
+    ros::Subscriber grid_map_sub_;
+    ros::Subscriber occupancy_grid_sub_;
+    ros::Subscriber start_pose_sub_;
+    ros::Publisher grid_map_pub_;
+    ros::Publisher path_pub_;
+
+    tf::TransformListener tf_listener_;
+
+    // Latest input, a new one replaces it
+    mutable std::mutex input_mutex_;
+    std::condition_variable input_condition_;
+    grid_map_msgs::GridMapConstPtr pending_grid_map_;
+    nav_msgs::OccupancyGridConstPtr pending_occupancy_grid_;
+    size_t num_dropped_inputs_;
+    bool shutdown_;
+
+    // The worker writes back_map_ only, readers share front_map_
+    mutable std::mutex buffer_mutex_;
+    std::shared_ptr<grid_map::GridMap> front_map_;
+    std::shared_ptr<grid_map::GridMap> back_map_;
+
+    grid_map_transforms::TransformWorkspace workspace_;
+
+    std::thread worker_;
+  };
+
+} /* namespace */
@@ -0,0 +1,455 @@
+#pragma once
+
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace grid_map_transforms{
+
+  /*
+   * Cost policies are template parameters of the exploration kernels below,
+   * so the per cell cost is inlined into the search loop. A policy provides
+   *
+   *   // False if the cell can not be entered, otherwise the cost added to
+   *   // the step cost when entering it (non-negative)
+   *   bool cellCost(const int index, float& cost) const;
+   *
+   *   // Upper bound of cellCost, sizes the bucket queue
+   *   float maxCellCost() const;
+   *
+   * Occupancy is checked before the policy is asked, only free cells reach
+   * cellCost.
+   */
+
+  /*
+   * The cost model of addExplorationTransform: cells closer than lethal_dist
+   * to an obstacle are blocked, cells closer than penalty_dist cost the
+   * squared difference.
+   */
+  class LethalPenaltyCost
+  {
+  public:
+    LethalPenaltyCost(const grid_map::Matrix& dist_data,
+                      const float lethal_dist = 6.0,
+                      const float penalty_dist = 12.0)
+      : dist_(dist_data.data())
+      , lethal_dist_(lethal_dist)
+      , penalty_dist_(penalty_dist)
+    {}
+
+    // Distances in another layout than the map, e.g. a TiledLayout copy
+    LethalPenaltyCost(const float* dist_data,
+                      const float lethal_dist = 6.0,
+                      const float penalty_dist = 12.0)
+      : dist_(dist_data)
+      , lethal_dist_(lethal_dist)
+      , penalty_dist_(penalty_dist)
+    {}
+
+    bool cellCost(const int index, float& cost) const
+    {
+      float dist = dist_[index];
+
+      if (dist < lethal_dist_)
+        return false;
+
+      cost = 0.0f;
+
+      if (dist < penalty_dist_){
+        float add_cost = (penalty_dist_ - dist);
+        cost = add_cost * add_cost;
+      }
+
+      return true;
+    }
+
+    float maxCellCost() const
+    {
+      float max_penalty = std::max(0.0f, penalty_dist_ - lethal_dist_);
+      return max_penalty * max_penalty;
+    }
+
+  protected:
+    const float* dist_;
+    float lethal_dist_;
+    float penalty_dist_;
+  };
+
+  /*
+   * LethalPenaltyCost plus weight times the value of a per cell
+   * traversability layer (e.g. slope or terrain roughness). Cells where the
+   * layer is NaN or infinite are blocked, negative values count as 0.
+   */
+  class TraversabilityCost
+  {
+  public:
+    TraversabilityCost(const grid_map::Matrix& dist_data,
+                       const grid_map::Matrix& traversability,
+                       const float weight = 1.0,
+                       const float lethal_dist = 6.0,
+                       const float penalty_dist = 12.0)
+      : base_cost_(dist_data, lethal_dist, penalty_dist)
+      , traversability_(traversability.data())
+      , weight_(weight)
+    {
+      float max_value = 0.0f;
+
+      for (int i = 0; i < traversability.size(); ++i){
+        if (std::isfinite(traversability_[i]))
+          max_value = std::max(max_value, traversability_[i]);
+      }
+
+      max_cell_cost_ = base_cost_.maxCellCost() + weight_ * max_value;
+    }
+
+    bool cellCost(const int index, float& cost) const
+    {
+      float value = traversability_[index];
+
+      if (!std::isfinite(value))
+        return false;
+
+      if (!base_cost_.cellCost(index, cost))
+        return false;
+
+      cost += weight_ * std::max(0.0f, value);
+      return true;
+    }
+
+    float maxCellCost() const { return max_cell_cost_; }
+
+  protected:
+    LethalPenaltyCost base_cost_;
+    const float* traversability_;
+    float weight_;
+    float max_cell_cost_;
+  };
+
+  /*
+   * Offsets from index to its neighbors (dx, dy) in a circular buffer of
+   * size_x by size_y cells, for cells flagged WRAPPED_CELL.
+   */
+  inline void wrappedOffsets(const int index,
+                             const int size_x,
+                             const int size_y,
+                             const int* dx,
+                             const int* dy,
+                             const int num_neighbors,
+                             int* offsets)
+  {
+    const int idx_x = index % size_x;
+    const int idx_y = index / size_x;
+
+    for (int i = 0; i < num_neighbors; ++i){
+      int x = (idx_x + dx[i] + size_x) % size_x;
+      int y = (idx_y + dy[i] + size_y) % size_y;
+      offsets[i] = x + y * size_x - index;
+    }
+  }
+
+  /*
+   * Linear index offsets and step costs for 4, 8 or 16 connectivity in a
+   * column major map with size_x rows. The 16 neighborhood adds the knight
+   * moves (sqrt(5) adjacent steps) after the 8 neighbors. A knight move
+   * passes between two cells (passed_offsets), both of which have to be
+   * enterable, and needs occupancy codes built with a border two cells wide
+   * (border_width). size_y is only needed for circular buffers.
+   */
+  template <int N>
+  struct Neighborhood
+  {
+    static const int num_neighbors = N;
+    static const int num_direct_neighbors = (N == 4) ? 4 : 8;
+    static const int border_width = (N == 16) ? 2 : 1;
+
+    explicit Neighborhood(const int size_x, const int size_y = 1)
+      : size_x(size_x)
+      , size_y(size_y)
+    {
+      static_assert((N == 4) || (N == 8) || (N == 16), "Neighborhood must be 4, 8 or 16 connected");
+
+      const float adjacent_dist = 0.955f;
+      const float diagonal_dist = 1.3693f;
+      const float knight_dist = 0.955f * std::sqrt(5.0f);
+
+      int i = 0;
+
+      for (int y = -1; y <= 1; ++y){
+        for (int x = -1; x <= 1; ++x){
+          bool diagonal = (x != 0) && (y != 0);
+
+          if (((x == 0) && (y == 0)) || (diagonal && N == 4))
+            continue;
+
+          dx[i] = x;
+          dy[i] = y;
+          offsets[i] = x + y * size_x;
+          costs[i] = diagonal ? diagonal_dist : adjacent_dist;
+          ++i;
+        }
+      }
+
+      for (int y = -2; (N == 16) && (y <= 2); ++y){
+        for (int x = -2; x <= 2; ++x){
+          if (std::abs(x) + std::abs(y) != 3)
+            continue;
+
+          // The two cells on either side of the line to the target
+          int step_x = (std::abs(x) == 2) ? x / 2 : 0;
+          int step_y = (std::abs(y) == 2) ? y / 2 : 0;
+
+          dx[i] = x;
+          dy[i] = y;
+          offsets[i] = x + y * size_x;
+          costs[i] = knight_dist;
+          passed_dx[i - num_direct_neighbors][0] = step_x;
+          passed_dy[i - num_direct_neighbors][0] = step_y;
+          passed_dx[i - num_direct_neighbors][1] = x - step_x;
+          passed_dy[i - num_direct_neighbors][1] = y - step_y;
+          passed_offsets[i][0] = step_x + step_y * size_x;
+          passed_offsets[i][1] = (x - step_x) + (y - step_y) * size_x;
+          ++i;
+        }
+      }
+    }
+
+    float minStepCost() const { return 0.955f; }
+    float maxStepCost() const { return *std::max_element(costs, costs + N); }
+
+    // Offsets of a WRAPPED_CELL in a circular buffer, see wrappedOffsets
+    void wrap(const int index,
+              int* wrapped_offsets,
+              int (*wrapped_passed_offsets)[2]) const
+    {
+      wrappedOffsets(index, size_x, size_y, dx, dy, N, wrapped_offsets);
+
+      for (int i = num_direct_neighbors; i < N; ++i){
+        wrappedOffsets(index, size_x, size_y,
+                       passed_dx[i - num_direct_neighbors],
+                       passed_dy[i - num_direct_neighbors],
+                       2, wrapped_passed_offsets[i]);
+      }
+    }
+
+    int size_x;
+    int size_y;
+    int dx[N];
+    int dy[N];
+    int offsets[N];
+    float costs[N];
+    int passed_offsets[N][2];
+
+    // Per knight move (N == 16 only), relative to the moving cell
+    int passed_dx[N - num_direct_neighbors + 1][2];
+    int passed_dy[N - num_direct_neighbors + 1][2];
+  };
+
+  template <class CostPolicy>
+  inline bool isCellEnterable(const unsigned char* occupancy_codes,
+                              const CostPolicy& cost_policy,
+                              const int index)
+  {
+    float cell_cost;
+    return ((occupancy_codes[index] & OCCUPANCY_CODE_MASK) == FREE_CELL) && cost_policy.cellCost(index, cell_cost);
+  }
+
+  template <class CostPolicy>
+  inline void touchExplorationCellBucketed(const unsigned char* occupancy_codes,
+                                           const CostPolicy& cost_policy,
+                                           float* expl_trans_map,
+                                           const int index,
+                                           const float curr_val,
+                                           const float add_cost,
+                                           const float bucket_width,
+                                           std::vector<std::vector<int> >& buckets,
+                                           size_t& num_pushed)
+  {
+    const unsigned char code = occupancy_codes[index];
+
+    //If not free at cell, return right away
+    if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+      return;
+
+    float cell_cost;
+
+    if (!cost_policy.cellCost(index, cell_cost))
+      return;
+
+    float cost = curr_val + add_cost + cell_cost;
+
+    if (expl_trans_map[index] > cost){
+      expl_trans_map[index] = cost;
+
+      if (!(code & BORDER_CELL)){
+        size_t bucket = static_cast<size_t>(cost / bucket_width);
+        buckets[bucket % buckets.size()].push_back(index);
+        ++num_pushed;
+      }
+    }
+  }
+
+  /*
+   * Bucketed exploration transform from goal_points into expl_layer, which
+   * must be initialized to std::numeric_limits<float>::max(). Cells are
+   * extracted in monotone cost order (bucket width is the smallest step
+   * cost), so each reachable cell is expanded once. occupancy_codes must
+   * have a border of at least Neighborhood::border_width.
+   */
+  template <class Neighborhood, class CostPolicy>
+  void propagateExploration(const OccupancyCodes& occupancy_codes,
+                            const CostPolicy& cost_policy,
+                            Eigen::Ref<grid_map::Matrix> expl_layer,
+                            const std::vector<grid_map::Index>& goal_points,
+                            ExplorationTransformStats* stats,
+                            std::vector<std::vector<int> >& buckets,
+                            std::vector<unsigned char>& settled)
+  {
+    const int size_x = expl_layer.rows();
+
+    const Neighborhood neighbors (size_x, expl_layer.cols());
+
+    // Every step costs at least the smallest step cost, so cells within one
+    // bucket of that width cannot improve each other and are final once reached.
+    float bucket_width = neighbors.minStepCost();
+    float max_step_cost = neighbors.maxStepCost() + cost_policy.maxCellCost();
+
+    size_t num_buckets = static_cast<size_t>(std::ceil(max_step_cost / bucket_width)) + 2;
+
+    // Buckets keep their capacity when reused, but must start out empty
+    buckets.resize(num_buckets);
+
+    for (size_t i = 0; i < num_buckets; ++i){
+      buckets[i].clear();
+    }
+
+    settled.assign(expl_layer.size(), 0);
+
+    size_t num_pushed = 0;
+    size_t num_settled = 0;
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      const grid_map::Index& point = goal_points[i];
+      expl_layer(point(0), point(1)) = 0.0;
+
+      if (!(occupancy_codes(point(0), point(1)) & BORDER_CELL)){
+        buckets[0].push_back(point(0) + point(1) * size_x);
+        ++num_pushed;
+      }
+    }
+
+    const unsigned char* codes = occupancy_codes.data();
+    float* expl = expl_layer.data();
+
+    size_t num_queued = num_pushed;
+
+    int wrapped_offsets[Neighborhood::num_neighbors];
+    int wrapped_passed_offsets[Neighborhood::num_neighbors][2];
+
+    for (size_t bucket = 0; num_queued > 0; ++bucket){
+      std::vector<int>& current_bucket = buckets[bucket % num_buckets];
+
+      // Rounding may put a cell into the current bucket, so pop until empty
+      while (!current_bucket.empty()){
+        int index = current_bucket.back();
+        current_bucket.pop_back();
+        --num_queued;
+
+        unsigned char& point_settled = settled[index];
+
+        if (point_settled)
+          continue;
+
+        point_settled = 1;
+        ++num_settled;
+
+        float current_val = expl[index];
+
+        size_t pushed_before = num_pushed;
+
+        const int* offsets = neighbors.offsets;
+        const int (*passed_offsets)[2] = neighbors.passed_offsets;
+
+        if (codes[index] & WRAPPED_CELL){
+          neighbors.wrap(index, wrapped_offsets, wrapped_passed_offsets);
+          offsets = wrapped_offsets;
+          passed_offsets = wrapped_passed_offsets;
+        }
+
+        for (int i = 0; i < Neighborhood::num_neighbors; ++i){
+          // Only knight moves pass between cells, the check vanishes otherwise
+          if ((i >= Neighborhood::num_direct_neighbors) &&
+              !(isCellEnterable(codes, cost_policy, index + passed_offsets[i][0]) &&
+                isCellEnterable(codes, cost_policy, index + passed_offsets[i][1]))){
+            continue;
+          }
+
+          touchExplorationCellBucketed(codes,
+                                       cost_policy,
+                                       expl,
+                                       index + offsets[i],
+                                       current_val,
+                                       neighbors.costs[i],
+                                       bucket_width,
+                                       buckets,
+                                       num_pushed);
+        }
+
+        num_queued += num_pushed - pushed_before;
+      }
+    }
+
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = num_settled;
+    }
+  }
+
+  /*
+   * Exploration transform with a custom cost policy and neighborhood, e.g.
+   *
+   *   TraversabilityCost cost (grid_map["distance_transform"], grid_map["slope"], 10.0);
+   *   addExplorationTransformCustom<Neighborhood<16> >(grid_map, goals, cost);
+   *
+   * With LethalPenaltyCost and Neighborhood<8> the result equals
+   * addExplorationTransformBucketed. The policy must stay valid during the
+   * call, adding expl_trans_layer does not move existing layers.
+   */
+  template <class Neighborhood, class CostPolicy>
+  bool addExplorationTransformCustom(grid_map::GridMap& grid_map,
+                                     const std::vector<grid_map::Index>& goal_points,
+                                     const CostPolicy& cost_policy,
+                                     const std::string occupancy_layer = "occupancy",
+                                     const std::string expl_trans_layer = "exploration_transform",
+                                     ExplorationTransformStats* stats = 0,
+                                     TransformWorkspace* workspace = 0)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    buildOccupancyCodes(grid_map[occupancy_layer], workspace->occupancy_codes, Neighborhood::border_width, grid_map.getStartIndex());
+
+    if (!grid_map.exists(expl_trans_layer))
+      grid_map.add(expl_trans_layer);
+
+    grid_map::Matrix& expl_layer (grid_map[expl_trans_layer]);
+    expl_layer.setConstant(std::numeric_limits<float>::max());
+
+    propagateExploration<Neighborhood>(workspace->occupancy_codes,
+                                       cost_policy,
+                                       expl_layer,
+                                       goal_points,
+                                       stats,
+                                       workspace->buckets,
+                                       workspace->cell_state);
+
+    return true;
+  }
+
+} /* namespace */
@@ -9,10 +9,73 @@
 
 #include <ros/ros.h>
 
+#include <algorithm>
 #include <queue>
 
+#include <stdint.h>
+
 namespace grid_map_transforms{
 
+    /*
+     * Occupancy as seen by the search kernels. The float occupancy layer is
+     * converted once per transform into one byte per cell (0 free, 100
+     * occupied, anything else including NaN unknown), so the hot loops read a
+     * quarter of the memory and compare integers. Cells on the map border
+     * additionally carry BORDER_CELL, mask with OCCUPANCY_CODE_MASK to get
+     * the occupancy. In circular buffers (GridMap::move), the border is
+     * where the map edge lies in the buffer, and cells on the buffer edge
+     * carry WRAPPED_CELL: their neighbors continue on the opposite edge.
+     */
+    enum OccupancyCode
+    {
+      FREE_CELL = 0,
+      OCCUPIED_CELL = 1,
+      UNKNOWN_CELL = 2,
+      OCCUPANCY_CODE_MASK = 3,
+      BORDER_CELL = 4,
+      WRAPPED_CELL = 8
+    };
+
+    typedef Eigen::Matrix<unsigned char, Eigen::Dynamic, Eigen::Dynamic> OccupancyCodes;
+
+    struct TransformWorkspace;
+
+    /*
+     * border_width rings of cells along the map edge are flagged
+     * BORDER_CELL, searches reaching further than one cell per step need
+     * more than one. start_index is the buffer start index of the map
+     * (GridMap::getStartIndex).
+     */
+    void buildOccupancyCodes(const grid_map::Matrix& occupancy,
+                             OccupancyCodes& occupancy_codes,
+                             const int border_width = 1,
+                             const grid_map::Index& start_index = grid_map::Index(0, 0));
+
+    /*
+     * The transforms accept circular buffer maps (GridMap::move), indices
+     * passed in and out are buffer indices. Searches, the distance
+     * transform update and the euclidean distance transform handle the
+     * buffer layout themselves. addInflatedLayer, addDistanceTransformCv and
+     * the Tiled, Parallel, ToStart and Hierarchical transforms run on a copy
+     * of their input layers in default start index order, so moved maps
+     * cost an extra copy there; call GridMap::convertToDefaultStartIndex
+     * once to avoid it. Only IncrementalExplorationTransform, which keeps
+     * state by buffer index, returns false for maps with a start index
+     * other than (0, 0).
+     */
+    inline bool isDefaultStartIndex(const grid_map::GridMap& grid_map)
+    {
+      return (grid_map.getStartIndex() == 0).all();
+    }
+
+    /*
+     * Refreshes the codes of changed_cells only, for callers that keep the
+     * codes alongside the occupancy layer.
+     */
+    void updateOccupancyCodes(const grid_map::Matrix& occupancy,
+                              const std::vector<grid_map::Index>& changed_cells,
+                              OccupancyCodes& occupancy_codes);
+
     /*
      * Adds a inflated layer to the provided grid_map.
      * Note inflation radius is given in map cells.
@@ -22,6 +85,24 @@ namespace grid_map_transforms{
                                        const std::string occupancy_layer = "occupancy",
                                        const std::string inflated_occupancy_layer = "occupancy_inflated");
 
+    /*
+     * Inflation by thresholding a distance transform instead of dilating, so
+     * cost does not depend on the radius. Free cells within
+     * inflation_radius_map_cells of an obstacle are marked occupied, which
+     * is dilation with an exact disc; cells on the rim may differ from the
+     * discretized ellipse used by addInflatedLayer. The radius is compared
+     * against an exact euclidean distance transform of all obstacles, in
+     * map cells, computed on the fly and not stored. A distance transform
+     * layer is not used: chamfer distances (addDistanceTransform, steps of
+     * 0.955 and 1.3693) are not in euclidean cells and only cover reachable
+     * space.
+     */
+    bool addInflatedLayerFromDistance(grid_map::GridMap& map,
+                                      const float inflation_radius_map_cells = 6.0,
+                                      const std::string occupancy_layer = "occupancy",
+                                      const std::string inflated_occupancy_layer = "occupancy_inflated",
+                                      const int num_threads = 1);
+
     bool addDistanceTransformCv(grid_map::GridMap& grid_map,
                             const std::string occupancy_layer = "occupancy",
                             const std::string dist_trans_layer = "distance_transform");
@@ -31,7 +112,83 @@ namespace grid_map_transforms{
                               std::vector<grid_map::Index>& obstacle_cells,
                               std::vector<grid_map::Index>& frontier_cells,
                               const std::string occupancy_layer = "occupancy",
-                              const std::string dist_trans_layer = "distance_transform");
+                              const std::string dist_trans_layer = "distance_transform",
+                              TransformWorkspace* workspace = 0);
+
+    /*
+     * Exact euclidean distance transform (separable lower envelope, one pass
+     * along x and one along y) with the same reachability seeding as
+     * addDistanceTransform. Runtime is O(N) and both passes are split across
+     * num_threads. Distances are in map cells like addDistanceTransformCv.
+     * Unlike the chamfer propagation, distances are measured in straight
+     * lines, so every free cell receives the distance to the closest
+     * reachable obstacle.
+     */
+    bool addDistanceTransformEdt(grid_map::GridMap& grid_map,
+                                 const grid_map::Index& seed_point,
+                                 std::vector<grid_map::Index>& obstacle_cells,
+                                 std::vector<grid_map::Index>& frontier_cells,
+                                 const int num_threads = 1,
+                                 const std::string occupancy_layer = "occupancy",
+                                 const std::string dist_trans_layer = "distance_transform",
+                                 TransformWorkspace* workspace = 0);
+
+    /*
+     * In place squared euclidean distance transform of a matrix in which seed
+     * cells are 0 and all other cells std::numeric_limits<float>::max().
+     * Cells stay at max if there is no seed at all. For layers of circular
+     * buffers, start_index is the buffer start index (GridMap::getStartIndex),
+     * distances do not wrap around the map edge.
+     */
+    void squaredEuclideanDistanceTransform(grid_map::Matrix& data,
+                                           const int num_threads = 1,
+                                           const grid_map::Index& start_index = grid_map::Index(0, 0));
+
+    /*
+     * Repairs an existing distance transform after the occupancy layer changed
+     * at changed_cells (dynamic brushfire). Cells that were derived from removed
+     * obstacles are raised, then the affected area is lowered again from the
+     * remaining valid wavefront, so work is proportional to the changed area.
+     * Reachability is not re-established: new obstacles are only seeded if they
+     * border the previously reached area. Run addDistanceTransform after larger
+     * topological changes. If changed_dist_cells is given, it receives (a
+     * superset of) the cells whose distance value changed.
+     * occupancy_codes are kept by the caller across updates and refreshed
+     * here at changed_cells only (updateOccupancyCodes). They are built
+     * from the occupancy layer when they do not match the map size, which
+     * takes time proportional to the map, so keep them from the first call.
+     */
+    bool updateDistanceTransform(grid_map::GridMap& grid_map,
+                                 const std::vector<grid_map::Index>& changed_cells,
+                                 OccupancyCodes& occupancy_codes,
+                                 const std::string occupancy_layer = "occupancy",
+                                 const std::string dist_trans_layer = "distance_transform",
+                                 std::vector<grid_map::Index>* changed_dist_cells = 0);
+
+    /*
+     * Collects cells in which occupancy differs from the copy kept in
+     * previous_occupancy_layer and updates that copy. Returns false (and creates
+     * the copy) if no previous layer exists yet.
+     */
+    bool collectChangedOccupancyCells(grid_map::GridMap& grid_map,
+                                      const std::string previous_occupancy_layer,
+                                      std::vector<grid_map::Index>& changed_cells,
+                                      const std::string occupancy_layer = "occupancy");
+
+    /*
+     * Work counters of exploration transform searches. With the FIFO queue,
+     * cells may be pushed several times before their value is final.
+     */
+    struct ExplorationTransformStats
+    {
+      ExplorationTransformStats()
+        : pushed_cells(0)
+        , settled_cells(0)
+      {}
+
+      size_t pushed_cells;
+      size_t settled_cells;
+    };
 
     bool addExplorationTransform(grid_map::GridMap& grid_map,
                             const std::vector<grid_map::Index>& goal_points,
@@ -39,110 +196,473 @@ namespace grid_map_transforms{
                             const float penalty_dist = 12.0,
                             const std::string occupancy_layer = "occupancy",
                             const std::string dist_trans_layer = "distance_transform",
-                            const std::string expl_trans_layer = "exploration_transform");
+                            const std::string expl_trans_layer = "exploration_transform",
+                            ExplorationTransformStats* stats = 0,
+                            TransformWorkspace* workspace = 0);
+
+    /*
+     * Same result as addExplorationTransform, but cells are extracted in
+     * monotone cost order from a bucket queue (bucket width is the minimum
+     * step cost), so each reachable cell is expanded exactly once.
+     */
+    bool addExplorationTransformBucketed(grid_map::GridMap& grid_map,
+                                         const std::vector<grid_map::Index>& goal_points,
+                                         const float lethal_dist = 6.0,
+                                         const float penalty_dist = 12.0,
+                                         const std::string occupancy_layer = "occupancy",
+                                         const std::string dist_trans_layer = "distance_transform",
+                                         const std::string expl_trans_layer = "exploration_transform",
+                                         ExplorationTransformStats* stats = 0,
+                                         TransformWorkspace* workspace = 0);
+
+    /*
+     * Exploration transforms of several goal sets (e.g. one per robot) on the
+     * same occupancy and distance layers. Occupancy codes are built once and
+     * goal sets are propagated independently (bucketed, as in
+     * addExplorationTransformBucketed) split across num_threads.
+     * expl_fields receives the fields one after another as structure of
+     * arrays: field k of the cell with linear index i is at
+     * k * num_cells + i, each field laid out like a layer.
+     */
+    bool computeExplorationTransformBatch(const grid_map::GridMap& grid_map,
+                                          const std::vector<std::vector<grid_map::Index> >& goal_sets,
+                                          std::vector<float>& expl_fields,
+                                          const float lethal_dist = 6.0,
+                                          const float penalty_dist = 12.0,
+                                          const int num_threads = 1,
+                                          const std::string occupancy_layer = "occupancy",
+                                          const std::string dist_trans_layer = "distance_transform",
+                                          ExplorationTransformStats* stats = 0,
+                                          TransformWorkspace* workspace = 0);
+
+    /*
+     * computeExplorationTransformBatch writing field k directly to the layer
+     * named expl_trans_layers[k]. Both lists must have the same size.
+     */
+    bool addExplorationTransformBatch(grid_map::GridMap& grid_map,
+                                      const std::vector<std::vector<grid_map::Index> >& goal_sets,
+                                      const std::vector<std::string>& expl_trans_layers,
+                                      const float lethal_dist = 6.0,
+                                      const float penalty_dist = 12.0,
+                                      const int num_threads = 1,
+                                      const std::string occupancy_layer = "occupancy",
+                                      const std::string dist_trans_layer = "distance_transform",
+                                      ExplorationTransformStats* stats = 0,
+                                      TransformWorkspace* workspace = 0);
+
+    /*
+     * addDistanceTransform and addExplorationTransformBucketed running on a
+     * tiled copy of the map (see TiledLayout): inputs are converted once,
+     * searched and converted back. The 8 neighbors of most cells then lie
+     * in the same 16 KB tile instead of three columns size_x floats apart,
+     * which keeps wavefronts on large maps in cache and TLB. Results are
+     * the same as those of the untiled transforms.
+     */
+    bool addDistanceTransformTiled(grid_map::GridMap& grid_map,
+                                   const grid_map::Index& seed_point,
+                                   std::vector<grid_map::Index>& obstacle_cells,
+                                   std::vector<grid_map::Index>& frontier_cells,
+                                   const std::string occupancy_layer = "occupancy",
+                                   const std::string dist_trans_layer = "distance_transform",
+                                   TransformWorkspace* workspace = 0);
+
+    bool addExplorationTransformTiled(grid_map::GridMap& grid_map,
+                                      const std::vector<grid_map::Index>& goal_points,
+                                      const float lethal_dist = 6.0,
+                                      const float penalty_dist = 12.0,
+                                      const std::string occupancy_layer = "occupancy",
+                                      const std::string dist_trans_layer = "distance_transform",
+                                      const std::string expl_trans_layer = "exploration_transform",
+                                      ExplorationTransformStats* stats = 0,
+                                      TransformWorkspace* workspace = 0);
+
+    /*
+     * Multi-threaded exploration transform (tiled delta stepping). The map is
+     * split into tiles of tile_size cells. Each round, tiles expand their
+     * pending cells in cost order up to a threshold that grows by about one
+     * tile per round. Tiles are processed in four colors so concurrently
+     * processed tiles never share cells, and improvements crossing a tile
+     * border are handed to the neighbor tile. Worker threads are started
+     * once and wait between phases. The result is the same fixed point as
+     * addExplorationTransform: the same cells are reached, and reached
+     * values a and b of the two satisfy |a - b| <= 1e-5 * max(1, |b|). They
+     * differ only where float sums of equal cost paths are added in a
+     * different order.
+     */
+    bool addExplorationTransformParallel(grid_map::GridMap& grid_map,
+                                         const std::vector<grid_map::Index>& goal_points,
+                                         const int num_threads,
+                                         const float lethal_dist = 6.0,
+                                         const float penalty_dist = 12.0,
+                                         const int tile_size = 64,
+                                         const std::string occupancy_layer = "occupancy",
+                                         const std::string dist_trans_layer = "distance_transform",
+                                         const std::string expl_trans_layer = "exploration_transform");
+
+    /*
+     * Part of the map touched by a goal directed exploration transform.
+     * min_index/max_index bound all cells that received a value (max_index
+     * is smaller than min_index if there were none). For circular buffer
+     * maps, the bounds are unwrapped indices (grid_map::getIndexFromBufferIndex).
+     */
+    struct ExploredRegion
+    {
+      ExploredRegion()
+        : min_index(0, 0)
+        , max_index(-1, -1)
+        , expanded_cells(0)
+        , reached_cells(0)
+        , start_reached(false)
+      {}
+
+      grid_map::Index min_index;
+      grid_map::Index max_index;
+      size_t expanded_cells;
+      size_t reached_cells;
+      bool start_reached;
+    };
+
+    /*
+     * Exploration transform for a single start cell, e.g. the robot pose.
+     * Cells are expanded from the goals in cost order (binary heap) and the
+     * search stops as soon as start_index is settled. With use_heuristic,
+     * the octile distance to the start scaled by the step costs is added
+     * (A*), which never overestimates since penalties are non-negative.
+     * Expanded cells hold exact values, cells on the open boundary upper
+     * bounds and all other cells std::numeric_limits<float>::max(), so
+     * gradient descent from the start yields the same path cost as with
+     * addExplorationTransform. If the start can not be reached, the whole
+     * reachable area is explored.
+     */
+    bool addExplorationTransformToStart(grid_map::GridMap& grid_map,
+                                        const std::vector<grid_map::Index>& goal_points,
+                                        const grid_map::Index& start_index,
+                                        const float lethal_dist = 6.0,
+                                        const float penalty_dist = 12.0,
+                                        const bool use_heuristic = true,
+                                        const std::string occupancy_layer = "occupancy",
+                                        const std::string dist_trans_layer = "distance_transform",
+                                        const std::string expl_trans_layer = "exploration_transform",
+                                        ExploredRegion* explored_region = 0,
+                                        TransformWorkspace* workspace = 0);
+
+    /*
+     * Coarse to fine exploration transform for a single start cell. The map
+     * is split into blocks of downsample_factor x downsample_factor cells
+     * (at most 64), and each connected part of the traversable cells inside
+     * a block becomes one coarse node, so walls thinner than a block are not
+     * crossed. The transform is computed on the coarse nodes, the coarse path
+     * from the start is dilated by corridor_radius blocks, and the full
+     * resolution transform is only computed inside that corridor. All other
+     * cells are std::numeric_limits<float>::max(), so path extraction from
+     * the start works unchanged. Values are exact for paths that stay inside
+     * the corridor and never below the full transform. If the start is not
+     * reached inside the corridor, the transform falls back to the whole
+     * map. explored_region receives the corridor bounding box and the cells
+     * expanded at full resolution.
+     */
+    bool addExplorationTransformHierarchical(grid_map::GridMap& grid_map,
+                                             const std::vector<grid_map::Index>& goal_points,
+                                             const grid_map::Index& start_index,
+                                             const int downsample_factor = 8,
+                                             const int corridor_radius = 2,
+                                             const float lethal_dist = 6.0,
+                                             const float penalty_dist = 12.0,
+                                             const std::string occupancy_layer = "occupancy",
+                                             const std::string dist_trans_layer = "distance_transform",
+                                             const std::string expl_trans_layer = "exploration_transform",
+                                             ExploredRegion* explored_region = 0,
+                                             TransformWorkspace* workspace = 0);
 
     bool collectReachableObstacleCells(grid_map::GridMap& grid_map,
                                        const grid_map::Index& seed_point,
                                        std::vector<grid_map::Index>& obstacle_cells,
                                        std::vector<grid_map::Index>& frontier_cells,
                                        const std::string occupancy_layer = "occupancy",
-                                       const std::string dist_seed_layer = "dist_seed_transform");
-
-    void touchExplorationCell(const grid_map::Matrix& grid_map,
-                              const grid_map::Matrix& dist_map,
-                         grid_map::Matrix& expl_trans_map,
-                         const int idx_x,
-                         const int idx_y,
-                         const float curr_val,
-                         const float add_cost,
-                         const float lethal_dist,
-                         const float penalty_dist,
-                         std::queue<grid_map::Index>& point_queue)
+                                       const std::string dist_seed_layer = "dist_seed_transform",
+                                       TransformWorkspace* workspace = 0);
+
+    /*
+     * Layers written by computeTransforms, can be combined.
+     */
+    enum TransformLayers
     {
-      //If not free at cell, return right away
-      if (grid_map(idx_x, idx_y) != 0)
-        return;
+      DISTANCE_TRANSFORM_LAYER = 1,
+      EXPLORATION_TRANSFORM_LAYER = 2
+    };
 
+    /*
+     * Runs reachability search, distance transform and exploration transform
+     * back-to-back on shared scratch buffers. Reachability is tracked in a
+     * byte per cell, so no dist_seed_transform layer is added, and only the
+     * layers selected in output_layers are written to the map (existing
+     * layers are reused). If goal_points is empty, the reachable frontier
+     * cells are used as goals.
+     */
+    bool computeTransforms(grid_map::GridMap& grid_map,
+                           const grid_map::Index& seed_point,
+                           const std::vector<grid_map::Index>& goal_points,
+                           std::vector<grid_map::Index>& obstacle_cells,
+                           std::vector<grid_map::Index>& frontier_cells,
+                           const int output_layers = DISTANCE_TRANSFORM_LAYER | EXPLORATION_TRANSFORM_LAYER,
+                           const float lethal_dist = 6.0,
+                           const float penalty_dist = 12.0,
+                           const std::string occupancy_layer = "occupancy",
+                           const std::string dist_trans_layer = "distance_transform",
+                           const std::string expl_trans_layer = "exploration_transform",
+                           TransformWorkspace* workspace = 0);
+
+    /*
+     * Distance or exploration transform in uint16 fixed point, half the
+     * memory of a float layer. A cell holds its value divided by scale and
+     * rounded; cells without value (std::numeric_limits<float>::max() in
+     * float layers) hold QUANTIZED_UNREACHED. Pick scale so that
+     * QUANTIZED_MAX_VALUE * scale covers the largest value of the field.
+     */
+    typedef Eigen::Matrix<uint16_t, Eigen::Dynamic, Eigen::Dynamic> QuantizedData;
 
-      float dist = dist_map(idx_x, idx_y);
+    const uint16_t QUANTIZED_UNREACHED = 0xFFFF;
+    const uint16_t QUANTIZED_MAX_VALUE = 0xFFFE;
 
-      if (dist < lethal_dist)
-        return;
+    struct DequantizeOp
+    {
+      typedef float result_type;
 
-      float cost = curr_val + add_cost;
+      explicit DequantizeOp(const float scale)
+        : scale(scale)
+      {}
 
-      //if (dist < 20.0){
-      //  cost += 1.0 * std::pow((20.0 - dist_map(idx_x, idx_y)), 2);
-      //}
-      if (dist < penalty_dist){
-        float add_cost = (penalty_dist - dist);
-        cost += add_cost * add_cost;
+      float operator()(const uint16_t value) const
+      {
+        return (value == QUANTIZED_UNREACHED) ? std::numeric_limits<float>::max() : value * scale;
       }
 
-      if (expl_trans_map(idx_x, idx_y) > cost){
-        expl_trans_map(idx_x, idx_y) = cost;
-        point_queue.push(grid_map::Index(idx_x, idx_y));
-      }
-    }
+      float scale;
+    };
 
-    void touchDistCell(const grid_map::Matrix& grid_map,
-                         grid_map::Matrix& expl_trans_map,
-                         const int idx_x,
-                         const int idx_y,
-                         const float curr_val,
-                         const float add_cost,
-                         std::queue<grid_map::Index>& point_queue)
+    struct QuantizedField
     {
-      //If not free at cell, return right away
-      if (grid_map(idx_x, idx_y) != 0)
-        return;
+      explicit QuantizedField(const float scale = 0.01f)
+        : scale(scale)
+      {}
 
-      float cost = curr_val + add_cost;
+      float value(const int idx_x, const int idx_y) const
+      {
+        return DequantizeOp(scale)(data(idx_x, idx_y));
+      }
 
-      if (expl_trans_map(idx_x, idx_y) > cost){
-        expl_trans_map(idx_x, idx_y) = cost;
-        point_queue.push(grid_map::Index(idx_x, idx_y));
+      // Float view without a copy, e.g. field.view().maxCoeff()
+      Eigen::CwiseUnaryOp<DequantizeOp, const QuantizedData> view() const
+      {
+        return data.unaryExpr(DequantizeOp(scale));
       }
-    }
 
-    void touchObstacleSearchCell(const grid_map::Matrix& grid_map,
-                         grid_map::Matrix& expl_trans_map,
-                         const grid_map::Index& current_point,
-                         const int idx_x,
-                         const int idx_y,
-                         std::vector<grid_map::Index>& obstacle_cells,
-                         std::vector<grid_map::Index>& frontier_cells,
-                         std::queue<grid_map::Index>& point_queue)
+      float scale;
+      QuantizedData data;
+    };
+
+    /*
+     * Quantizes a float layer with the scale of field. Values above the range
+     * saturate at QUANTIZED_MAX_VALUE.
+     */
+    void quantizeField(const grid_map::Matrix& data,
+                       QuantizedField& field);
+
+    /*
+     * Writes the float values of field to layer, for consumers of float
+     * layers. The field must have the size of the map.
+     */
+    bool addQuantizedFieldLayer(grid_map::GridMap& grid_map,
+                                const QuantizedField& field,
+                                const std::string layer);
+
+    /*
+     * addDistanceTransform computed directly in dist_field. Reachability is
+     * tracked in the workspace instead of a dist_seed_transform layer, and
+     * step costs are rounded to multiples of dist_field.scale. Distances
+     * beyond the range saturate at QUANTIZED_MAX_VALUE.
+     */
+    bool computeDistanceTransformQuantized(const grid_map::GridMap& grid_map,
+                                           const grid_map::Index& seed_point,
+                                           std::vector<grid_map::Index>& obstacle_cells,
+                                           std::vector<grid_map::Index>& frontier_cells,
+                                           QuantizedField& dist_field,
+                                           const std::string occupancy_layer = "occupancy",
+                                           TransformWorkspace* workspace = 0);
+
+    /*
+     * Bucketed exploration transform on quantized fields with integer costs
+     * (step and penalty costs rounded to multiples of expl_field.scale,
+     * penalties looked up by quantized distance). Cells whose cost exceeds
+     * the range of expl_field stay QUANTIZED_UNREACHED.
+     */
+    bool computeExplorationTransformQuantized(const grid_map::GridMap& grid_map,
+                                              const std::vector<grid_map::Index>& goal_points,
+                                              const QuantizedField& dist_field,
+                                              QuantizedField& expl_field,
+                                              const float lethal_dist = 6.0,
+                                              const float penalty_dist = 12.0,
+                                              const std::string occupancy_layer = "occupancy",
+                                              ExplorationTransformStats* stats = 0,
+                                              TransformWorkspace* workspace = 0);
+
+    /*
+     * Scratch memory of the transforms. Transforms run at every map update
+     * can share one workspace, so codes, queues and per cell flags stay
+     * allocated between calls instead of being created and zeroed by the
+     * allocator each time. Buffers are resized to the map on use and keep
+     * their capacity, only the occupancy codes are reallocated when the
+     * number of cells changes. Not to be used by concurrent calls. Output
+     * layers that already exist are reset in place whether or not a
+     * workspace is passed.
+     */
+    struct TransformWorkspace
     {
-      // Free
-      if ( (grid_map(idx_x, idx_y) == 0.0) ){
-        if (expl_trans_map(idx_x, idx_y) != std::numeric_limits<float>::max()){
-          return;
-        }else{
-          expl_trans_map(idx_x, idx_y) = -3.0;
-          point_queue.push(grid_map::Index(idx_x, idx_y));
+      OccupancyCodes occupancy_codes;
+
+      // Ring buffer of the search queue
+      std::vector<int> queue_buffer;
+
+      // Reachability state, settled or closed flags, one byte per cell
+      std::vector<unsigned char> cell_state;
+
+      std::vector<std::vector<int> > buckets;
+      std::vector<std::pair<float, int> > heap;
+
+      // Distance transform of computeTransforms if it is not written out
+      grid_map::Matrix dist_scratch;
+
+      // Tiled copies used by the *Tiled transforms
+      std::vector<unsigned char> tiled_codes;
+      std::vector<float> tiled_dist;
+      std::vector<float> tiled_expl;
+    };
+
+    /*
+     * Map cells stored tile by tile, 64 x 64 cells per tile, each tile
+     * column major and tiles in column major order. Maps are padded to whole
+     * tiles. Neighbors of cells inside a tile are at fixed offsets, only
+     * cells on the tile rim need their coordinates.
+     */
+    class TiledLayout
+    {
+    public:
+      static const int TILE_BITS = 6;
+      static const int TILE_SIZE = 1 << TILE_BITS;
+      static const int TILE_MASK = TILE_SIZE - 1;
+      static const int TILE_CELLS = TILE_SIZE * TILE_SIZE;
+
+      TiledLayout(const int size_x, const int size_y)
+        : size_x_(size_x)
+        , size_y_(size_y)
+        , tiles_x_((size_x + TILE_MASK) >> TILE_BITS)
+        , tiles_y_((size_y + TILE_MASK) >> TILE_BITS)
+      {
+        int i = 0;
+
+        // Same order as NeighborOffsets
+        for (int y = -1; y <= 1; ++y){
+          for (int x = -1; x <= 1; ++x){
+            if ((x == 0) && (y == 0))
+              continue;
+
+            dx_[i] = x;
+            dy_[i] = y;
+            offsets_[i] = x + y * TILE_SIZE;
+            ++i;
+          }
         }
-      // Occupied
-      }else if (grid_map(idx_x, idx_y) == 100.0){
-        if (expl_trans_map(idx_x, idx_y) == -1.0){
-          return;
+      }
+
+      size_t size() const
+      {
+        return static_cast<size_t>(tiles_x_) * tiles_y_ * TILE_SIZE * TILE_SIZE;
+      }
+
+      int numTiles() const { return tiles_x_ * tiles_y_; }
+
+      // Tile of a tiled index, its cells are tile * TILE_CELLS onwards
+      static int tile(const int index) { return index >> (2 * TILE_BITS); }
+
+      int sizeX() const { return size_x_; }
+      int sizeY() const { return size_y_; }
+
+      int index(const int idx_x, const int idx_y) const
+      {
+        int tile = (idx_x >> TILE_BITS) + (idx_y >> TILE_BITS) * tiles_x_;
+        return (tile << (2 * TILE_BITS)) | ((idx_y & TILE_MASK) << TILE_BITS) | (idx_x & TILE_MASK);
+      }
+
+      grid_map::Index cell(const int index) const
+      {
+        int tile = index >> (2 * TILE_BITS);
+        return grid_map::Index(((tile % tiles_x_) << TILE_BITS) | (index & TILE_MASK),
+                               ((tile / tiles_x_) << TILE_BITS) | ((index >> TILE_BITS) & TILE_MASK));
+      }
+
+      // Tiled indices of the 8 neighbors, in the order of NeighborOffsets
+      void neighbors(const int index, int* neighbor_indices) const
+      {
+        int local_x = index & TILE_MASK;
+        int local_y = (index >> TILE_BITS) & TILE_MASK;
+
+        if ((local_x > 0) && (local_x < TILE_MASK) && (local_y > 0) && (local_y < TILE_MASK)){
+          for (int i = 0; i < 8; ++i){
+            neighbor_indices[i] = index + offsets_[i];
+          }
         }else{
-          expl_trans_map(idx_x, idx_y) = -1.0;
-          obstacle_cells.push_back(grid_map::Index(idx_x, idx_y));
+          grid_map::Index point (cell(index));
+
+          for (int i = 0; i < 8; ++i){
+            neighbor_indices[i] = this->index(point(0) + dx_[i], point(1) + dy_[i]);
+          }
         }
-      // Unknown
-      }else{
-        if (expl_trans_map(current_point(0), current_point(1)) == -2.0){
-          return;
-        }else{
-          expl_trans_map(current_point(0), current_point(1)) = -2.0;
-          frontier_cells.push_back(grid_map::Index(current_point(0), current_point(1)));
+      }
+
+      // Copies a column major matrix into tiled storage, padding cells get pad_value
+      template <class Scalar>
+      void toTiled(const Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& data,
+                   std::vector<Scalar>& tiled,
+                   const Scalar pad_value) const
+      {
+        tiled.assign(size(), pad_value);
+
+        // A copy, std::min binds references and the constant has no definition
+        const int tile_size = TILE_SIZE;
+
+        // Runs of up to TILE_SIZE cells are contiguous in both layouts
+        for (int idx_y = 0; idx_y < size_y_; ++idx_y){
+          for (int idx_x = 0; idx_x < size_x_; idx_x += TILE_SIZE){
+            std::copy(&data(idx_x, idx_y),
+                      &data(idx_x, idx_y) + std::min(tile_size, size_x_ - idx_x),
+                      &tiled[index(idx_x, idx_y)]);
+          }
         }
       }
 
+      template <class Scalar>
+      void fromTiled(const std::vector<Scalar>& tiled,
+                     Eigen::Matrix<Scalar, Eigen::Dynamic, Eigen::Dynamic>& data) const
+      {
+        const int tile_size = TILE_SIZE;
 
-    }
+        for (int idx_y = 0; idx_y < size_y_; ++idx_y){
+          for (int idx_x = 0; idx_x < size_x_; idx_x += TILE_SIZE){
+            const Scalar* run = &tiled[index(idx_x, idx_y)];
+            std::copy(run, run + std::min(tile_size, size_x_ - idx_x), &data(idx_x, idx_y));
+          }
+        }
+      }
 
+    protected:
+      int size_x_;
+      int size_y_;
+      int tiles_x_;
+      int tiles_y_;
 
+      int dx_[8];
+      int dy_[8];
+      int offsets_[8];
+    };
 
 } /* namespace */
@@ -0,0 +1,36 @@
+#include <grid_map_proc/grid_map_cv_bridge.h>
+
+#include <opencv2/imgproc/imgproc.hpp>
+
+namespace grid_map_cv_bridge{
+
+  cv::Mat getTransposedView(grid_map::Matrix& data)
+  {
+    return cv::Mat(data.cols(), data.rows(), CV_32FC1, data.data());
+  }
+
+  cv::Mat getTransposedView(const grid_map::Matrix& data)
+  {
+    return cv::Mat(data.cols(), data.rows(), CV_32FC1, const_cast<float*>(data.data()));
+  }
+
+  void getComparisonMask(const grid_map::Matrix& data,
+                         const float value,
+                         const int cmp_op,
+                         cv::Mat& mask)
+  {
+    // cv::compare uses vectorized kernels and writes 255/0 directly
+    cv::compare(getTransposedView(data), value, mask, cmp_op);
+  }
+
+  grid_map::Matrix& getOrAddLayer(grid_map::GridMap& grid_map,
+                                  const std::string& layer)
+  {
+    if (!grid_map.exists(layer)){
+      grid_map.add(layer);
+    }
+
+    return grid_map[layer];
+  }
+
+} /* namespace */
@@ -0,0 +1,287 @@
+#include <grid_map_proc/grid_map_exploration_transform.h>
+
+namespace grid_map_transforms{
+
+  IncrementalExplorationTransform::IncrementalExplorationTransform(const float lethal_dist,
+                                                                   const float penalty_dist,
+                                                                   const std::string occupancy_layer,
+                                                                   const std::string dist_trans_layer,
+                                                                   const std::string expl_trans_layer)
+    : lethal_dist_(lethal_dist)
+    , penalty_dist_(penalty_dist)
+    , occupancy_layer_(occupancy_layer)
+    , dist_trans_layer_(dist_trans_layer)
+    , expl_trans_layer_(expl_trans_layer)
+    , size_(0, 0)
+    , needs_reset_(true)
+    , num_expanded_cells_(0)
+  {
+  }
+
+  void IncrementalExplorationTransform::setGoals(const std::vector<grid_map::Index>& goal_points)
+  {
+    // Removed goals have to be repaired as well
+    for (size_t i = 0; i < goals_.size(); ++i){
+      pending_cells_.push_back(goals_[i]);
+    }
+
+    goals_ = goal_points;
+
+    for (size_t i = 0; i < goals_.size(); ++i){
+      pending_cells_.push_back(goals_[i]);
+    }
+  }
+
+  void IncrementalExplorationTransform::addGoal(const grid_map::Index& goal_point)
+  {
+    goals_.push_back(goal_point);
+    pending_cells_.push_back(goal_point);
+  }
+
+  void IncrementalExplorationTransform::removeGoal(const grid_map::Index& goal_point)
+  {
+    for (size_t i = 0; i < goals_.size(); ++i){
+      if ((goals_[i] == goal_point).all()){
+        goals_.erase(goals_.begin() + i);
+        pending_cells_.push_back(goal_point);
+        return;
+      }
+    }
+  }
+
+  void IncrementalExplorationTransform::markCellsChanged(const std::vector<grid_map::Index>& changed_cells)
+  {
+    pending_cells_.insert(pending_cells_.end(), changed_cells.begin(), changed_cells.end());
+  }
+
+  void IncrementalExplorationTransform::reset()
+  {
+    needs_reset_ = true;
+  }
+
+  void IncrementalExplorationTransform::initialize(const grid_map::Size& size)
+  {
+    size_ = size;
+
+    g_.setConstant(size_(0), size_(1), std::numeric_limits<float>::max());
+    rhs_.setConstant(size_(0), size_(1), std::numeric_limits<float>::max());
+
+    goal_mask_.assign(g_.size(), 0);
+    applied_goals_.clear();
+
+    queue_ = std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> >();
+    changed_cells_.clear();
+
+    // Goals are inserted again below, everything else starts out consistent
+    pending_cells_ = goals_;
+
+    needs_reset_ = false;
+  }
+
+  bool IncrementalExplorationTransform::update(grid_map::GridMap& grid_map)
+  {
+    if (!grid_map.exists(occupancy_layer_))
+      return false;
+
+    if (!isDefaultStartIndex(grid_map))
+      return false;
+
+    if (!grid_map.exists(dist_trans_layer_))
+      return false;
+
+    const grid_map::Matrix& grid_data (grid_map[occupancy_layer_]);
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer_]);
+
+    bool full_update = needs_reset_ || (grid_map.getSize() != size_).any() || !grid_map.exists(expl_trans_layer_);
+
+    if (full_update){
+      initialize(grid_map.getSize());
+      buildOccupancyCodes(grid_data, occupancy_codes_);
+    }else{
+      updateOccupancyCodes(grid_data, pending_cells_, occupancy_codes_);
+    }
+
+    for (size_t i = 0; i < applied_goals_.size(); ++i){
+      goal_mask_[applied_goals_[i](0) + applied_goals_[i](1) * size_(0)] = 0;
+    }
+
+    for (size_t i = 0; i < goals_.size(); ++i){
+      goal_mask_[goals_[i](0) + goals_[i](1) * size_(0)] = 1;
+    }
+
+    applied_goals_ = goals_;
+
+    for (size_t i = 0; i < pending_cells_.size(); ++i){
+      const grid_map::Index& point = pending_cells_[i];
+      updateCell(occupancy_codes_, dist_data, point(0), point(1));
+    }
+    pending_cells_.clear();
+
+    num_expanded_cells_ = 0;
+
+    computeTransform(occupancy_codes_, dist_data);
+
+    if (full_update){
+      grid_map.add(expl_trans_layer_, g_);
+    }else{
+      grid_map::Matrix& expl_layer (grid_map[expl_trans_layer_]);
+
+      for (size_t i = 0; i < changed_cells_.size(); ++i){
+        expl_layer.data()[changed_cells_[i]] = g_.data()[changed_cells_[i]];
+      }
+    }
+    changed_cells_.clear();
+
+    return true;
+  }
+
+  void IncrementalExplorationTransform::updateCell(const OccupancyCodes& occupancy_codes,
+                                                   const grid_map::Matrix& dist_data,
+                                                   const int idx_x,
+                                                   const int idx_y)
+  {
+    const float max_val = std::numeric_limits<float>::max();
+
+    int index = idx_x + idx_y * size_(0);
+    float rhs = max_val;
+
+    if (goal_mask_[index]){
+      rhs = 0.0;
+
+    // Same cost model as touchExplorationCell
+    }else if (((occupancy_codes(idx_x, idx_y) & OCCUPANCY_CODE_MASK) == FREE_CELL) && (dist_data(idx_x, idx_y) >= lethal_dist_)){
+      float dist = dist_data(idx_x, idx_y);
+
+      for (int x = idx_x-1; x <= idx_x+1; ++x){
+        for (int y = idx_y-1; y <= idx_y+1; ++y){
+          //Cells at the border never propagate
+          if (x < 1 || x >= size_(0)-1 || y < 1 || y >= size_(1)-1)
+            continue;
+
+          if ((x == idx_x) && (y == idx_y))
+            continue;
+
+          float neighbor_val = g_(x, y);
+
+          if (neighbor_val == max_val)
+            continue;
+
+          float cost = neighbor_val + (((x != idx_x) && (y != idx_y)) ? 1.3693f : 0.955f);
+
+          if (dist < penalty_dist_){
+            float add_cost = (penalty_dist_ - dist);
+            cost += add_cost * add_cost;
+          }
+
+          rhs = std::min(rhs, cost);
+        }
+      }
+    }
+
+    rhs_(idx_x, idx_y) = rhs;
+
+    float g = g_(idx_x, idx_y);
+
+    if (g != rhs){
+      queue_.push(QueueEntry(std::min(g, rhs), index));
+    }
+  }
+
+  void IncrementalExplorationTransform::updateNeighbors(const OccupancyCodes& occupancy_codes,
+                                                        const grid_map::Matrix& dist_data,
+                                                        const int idx_x,
+                                                        const int idx_y)
+  {
+    //Cells at the border never propagate
+    if (idx_x < 1 || idx_x >= size_(0)-1 || idx_y < 1 || idx_y >= size_(1)-1)
+      return;
+
+    for (int x = idx_x-1; x <= idx_x+1; ++x){
+      for (int y = idx_y-1; y <= idx_y+1; ++y){
+        if ((x == idx_x) && (y == idx_y))
+          continue;
+
+        updateCell(occupancy_codes, dist_data, x, y);
+      }
+    }
+  }
+
+  void IncrementalExplorationTransform::lowerNeighbors(const OccupancyCodes& occupancy_codes,
+                                                       const grid_map::Matrix& dist_data,
+                                                       const int idx_x,
+                                                       const int idx_y)
+  {
+    //Cells at the border never propagate
+    if (idx_x < 1 || idx_x >= size_(0)-1 || idx_y < 1 || idx_y >= size_(1)-1)
+      return;
+
+    float current_val = g_(idx_x, idx_y);
+
+    // g only decreased, so neighbors can be relaxed without a full rhs scan
+    for (int x = idx_x-1; x <= idx_x+1; ++x){
+      for (int y = idx_y-1; y <= idx_y+1; ++y){
+        if ((x == idx_x) && (y == idx_y))
+          continue;
+
+        if (((occupancy_codes(x, y) & OCCUPANCY_CODE_MASK) != FREE_CELL) || goal_mask_[x + y * size_(0)])
+          continue;
+
+        float dist = dist_data(x, y);
+
+        if (dist < lethal_dist_)
+          continue;
+
+        float cost = current_val + (((x != idx_x) && (y != idx_y)) ? 1.3693f : 0.955f);
+
+        if (dist < penalty_dist_){
+          float add_cost = (penalty_dist_ - dist);
+          cost += add_cost * add_cost;
+        }
+
+        if (rhs_(x, y) > cost){
+          rhs_(x, y) = cost;
+
+          float g = g_(x, y);
+
+          if (g != cost){
+            queue_.push(QueueEntry(std::min(g, cost), x + y * size_(0)));
+          }
+        }
+      }
+    }
+  }
+
+  void IncrementalExplorationTransform::computeTransform(const OccupancyCodes& occupancy_codes,
+                                                         const grid_map::Matrix& dist_data)
+  {
+    while (queue_.size()){
+      QueueEntry entry (queue_.top());
+      queue_.pop();
+
+      int index = entry.second;
+
+      float& g = g_.data()[index];
+      float rhs = rhs_.data()[index];
+
+      // Outdated entry, cell is consistent or has been queued again
+      if ((g == rhs) || (entry.first != std::min(g, rhs)))
+        continue;
+
+      int idx_x = index % size_(0);
+      int idx_y = index / size_(0);
+
+      ++num_expanded_cells_;
+      changed_cells_.push_back(index);
+
+      if (g > rhs){
+        g = rhs;
+        lowerNeighbors(occupancy_codes, dist_data, idx_x, idx_y);
+      }else{
+        g = std::numeric_limits<float>::max();
+        updateCell(occupancy_codes, dist_data, idx_x, idx_y);
+        updateNeighbors(occupancy_codes, dist_data, idx_x, idx_y);
+      }
+    }
+  }
+
+} /* namespace */
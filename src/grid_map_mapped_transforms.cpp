@@ -0,0 +1,661 @@
+#include <grid_map_proc/grid_map_mapped_transforms.h>
+#include <grid_map_proc/grid_map_transform_policies.h>
+
+#include "grid_map_transforms_internal.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <functional>
+#include <limits>
+#include <queue>
+
+namespace grid_map_transforms{
+
+  MappedTileFile::MappedTileFile()
+    : layout_(0, 0)
+    , cell_bytes_(0)
+    , num_bytes_(0)
+    , data_(0)
+    , fd_(-1)
+  {}
+
+  MappedTileFile::~MappedTileFile()
+  {
+    close();
+  }
+
+  bool MappedTileFile::map(const std::string& file_name,
+                           const int size_x,
+                           const int size_y,
+                           const size_t cell_bytes,
+                           const bool create)
+  {
+    close();
+
+    if ((size_x <= 0) || (size_y <= 0))
+      return false;
+
+    TiledLayout layout (size_x, size_y);
+    size_t num_bytes = layout.size() * cell_bytes;
+
+    int fd = ::open(file_name.c_str(), create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDWR, 0644);
+
+    if (fd < 0)
+      return false;
+
+    if (create){
+      if (::ftruncate(fd, static_cast<off_t>(num_bytes)) != 0){
+        ::close(fd);
+        return false;
+      }
+    }else{
+      struct stat file_stat;
+
+      if ((::fstat(fd, &file_stat) != 0) || (static_cast<size_t>(file_stat.st_size) != num_bytes)){
+        ::close(fd);
+        return false;
+      }
+    }
+
+    void* data = ::mmap(0, num_bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (data == MAP_FAILED){
+      ::close(fd);
+      return false;
+    }
+
+    // Tiles are accessed out of file order
+    ::madvise(data, num_bytes, MADV_RANDOM);
+
+    layout_ = layout;
+    cell_bytes_ = cell_bytes;
+    num_bytes_ = num_bytes;
+    data_ = data;
+    fd_ = fd;
+
+    return true;
+  }
+
+  void MappedTileFile::releaseTile(const int tile) const
+  {
+    size_t tile_bytes = TiledLayout::TILE_CELLS * cell_bytes_;
+
+    // Dirty pages of a shared mapping are kept in the file
+    ::madvise(static_cast<char*>(data_) + static_cast<size_t>(tile) * tile_bytes, tile_bytes, MADV_DONTNEED);
+  }
+
+  void MappedTileFile::releaseAll() const
+  {
+    if (data_)
+      ::madvise(data_, num_bytes_, MADV_DONTNEED);
+  }
+
+  void MappedTileFile::close()
+  {
+    if (data_)
+      ::munmap(data_, num_bytes_);
+
+    if (fd_ >= 0)
+      ::close(fd_);
+
+    data_ = 0;
+    fd_ = -1;
+    num_bytes_ = 0;
+  }
+
+  ResidentTiles::ResidentTiles(const int num_tiles,
+                               const int max_resident_tiles)
+    // A tile and its 8 neighbors are used together
+    : max_resident_tiles_(std::max(max_resident_tiles, 9))
+    , num_evicted_(0)
+    , positions_(num_tiles)
+    , resident_(num_tiles, 0)
+  {}
+
+  void ResidentTiles::touch(const int tile,
+                            const int current_tile)
+  {
+    if (resident_[tile]){
+      lru_.splice(lru_.begin(), lru_, positions_[tile]);
+      return;
+    }
+
+    lru_.push_front(tile);
+    positions_[tile] = lru_.begin();
+    resident_[tile] = 1;
+
+    if (lru_.size() <= max_resident_tiles_)
+      return;
+
+    // Read faults also map cached pages next to the faulting one
+    // (fault-around), those are dropped by releasing everything once in a
+    // while. Released tiles fault back in from the page cache.
+    if (++num_evicted_ >= max_resident_tiles_){
+      releaseAll();
+
+      // Both are in use, they fault back in and have to be tracked again
+      if ((current_tile >= 0) && (current_tile != tile))
+        touch(current_tile);
+
+      touch(tile);
+      return;
+    }
+
+    int evicted = lru_.back();
+    lru_.pop_back();
+    resident_[evicted] = 0;
+
+    for (size_t i = 0; i < grids_.size(); ++i){
+      grids_[i]->releaseTile(evicted);
+    }
+  }
+
+  void ResidentTiles::releaseAll()
+  {
+    for (std::list<int>::const_iterator it = lru_.begin(); it != lru_.end(); ++it){
+      resident_[*it] = 0;
+    }
+
+    lru_.clear();
+    num_evicted_ = 0;
+
+    for (size_t i = 0; i < grids_.size(); ++i){
+      grids_[i]->releaseAll();
+    }
+  }
+
+  /*
+   * Work queue of the out of core searches. Cells queued for other tiles
+   * wait with their tile, tiles are processed in order of their lowest
+   * queued value and their cells through a FIFO local to the tile.
+   */
+  class MappedTileQueue
+  {
+  public:
+    explicit MappedTileQueue(const int num_tiles)
+      : pending_(num_tiles)
+      , keys_(num_tiles, std::numeric_limits<float>::max())
+      , queued_(TiledLayout::TILE_CELLS, 0)
+      , current_tile_(-1)
+    {
+      local_queue_.reset(TiledLayout::TILE_CELLS);
+    }
+
+    int currentTile() const { return current_tile_; }
+
+    // Queues index with value, directly if it is in the current tile
+    void push(const int index, const float value)
+    {
+      int tile = TiledLayout::tile(index);
+
+      if (tile == current_tile_){
+        unsigned char& queued = queued_[index & (TiledLayout::TILE_CELLS - 1)];
+
+        if (!queued){
+          queued = 1;
+          local_queue_.push(index);
+        }
+        return;
+      }
+
+      pending_[tile].push_back(index);
+
+      if (value < keys_[tile]){
+        keys_[tile] = value;
+        tile_heap_.push(std::make_pair(value, tile));
+      }
+    }
+
+    // Moves the queued cells of the next tile into the local FIFO
+    bool nextTile()
+    {
+      current_tile_ = -1;
+
+      while (!tile_heap_.empty()){
+        std::pair<float, int> top = tile_heap_.top();
+        tile_heap_.pop();
+
+        // Stale, the tile was lowered or processed since
+        if (top.first != keys_[top.second])
+          continue;
+
+        current_tile_ = top.second;
+        keys_[current_tile_] = std::numeric_limits<float>::max();
+
+        std::vector<int>& pending = pending_[current_tile_];
+
+        for (size_t i = 0; i < pending.size(); ++i){
+          push(pending[i], 0.0f);
+        }
+
+        std::vector<int>().swap(pending);
+        return true;
+      }
+
+      return false;
+    }
+
+    bool pop(int& index)
+    {
+      if (local_queue_.empty())
+        return false;
+
+      index = local_queue_.pop();
+      queued_[index & (TiledLayout::TILE_CELLS - 1)] = 0;
+      return true;
+    }
+
+  protected:
+    std::vector<std::vector<int> > pending_;
+    std::vector<float> keys_;
+    std::priority_queue<std::pair<float, int>,
+                        std::vector<std::pair<float, int> >,
+                        std::greater<std::pair<float, int> > > tile_heap_;
+
+    CellQueue local_queue_;
+    std::vector<unsigned char> queued_;
+    int current_tile_;
+  };
+
+  // Keeps the tile of a neighbor resident while it is accessed
+  inline void touchNeighborTile(ResidentTiles& resident_tiles,
+                                const int current_tile,
+                                const int index)
+  {
+    int tile = TiledLayout::tile(index);
+
+    if (tile != current_tile)
+      resident_tiles.touch(tile, current_tile);
+  }
+
+  template <class Scalar>
+  void fillMappedGrid(const MappedTiledGrid<Scalar>& grid,
+                      const Scalar value)
+  {
+    for (int tile = 0; tile < grid.layout().numTiles(); ++tile){
+      Scalar* tile_data = grid.data() + static_cast<size_t>(tile) * TiledLayout::TILE_CELLS;
+      std::fill(tile_data, tile_data + TiledLayout::TILE_CELLS, value);
+      grid.releaseTile(tile);
+    }
+  }
+
+  inline bool sameSize(const MappedTileFile& grid_a,
+                       const MappedTileFile& grid_b)
+  {
+    return grid_a.isOpen() && grid_b.isOpen() &&
+           (grid_a.layout().sizeX() == grid_b.layout().sizeX()) &&
+           (grid_a.layout().sizeY() == grid_b.layout().sizeY());
+  }
+
+  // Copies count cells of row idx_y of a circular buffer layer, starting at
+  // unwrapped column idx_x, into run. The cells are split where they wrap
+  // around the buffer edge.
+  void readWrappedRun(const grid_map::Matrix& layer,
+                      const grid_map::Index& start_index,
+                      const int idx_x,
+                      const int idx_y,
+                      const int count,
+                      float* run)
+  {
+    const int buffer_x = (idx_x + start_index(0)) % layer.rows();
+    const int buffer_y = (idx_y + start_index(1)) % layer.cols();
+    const int first = std::min(count, static_cast<int>(layer.rows()) - buffer_x);
+
+    std::copy(&layer(buffer_x, buffer_y), &layer(buffer_x, buffer_y) + first, run);
+    std::copy(&layer(0, buffer_y), &layer(0, buffer_y) + (count - first), run + first);
+  }
+
+  void writeWrappedRun(const float* run,
+                       const grid_map::Index& start_index,
+                       const int idx_x,
+                       const int idx_y,
+                       const int count,
+                       grid_map::Matrix& layer)
+  {
+    const int buffer_x = (idx_x + start_index(0)) % layer.rows();
+    const int buffer_y = (idx_y + start_index(1)) % layer.cols();
+    const int first = std::min(count, static_cast<int>(layer.rows()) - buffer_x);
+
+    std::copy(run, run + first, &layer(buffer_x, buffer_y));
+    std::copy(run + first, run + count, &layer(0, buffer_y));
+  }
+
+  bool importMappedLayer(const grid_map::Matrix& layer,
+                         const grid_map::Index& start_index,
+                         MappedTiledGrid<float>& grid)
+  {
+    const TiledLayout& layout (grid.layout());
+
+    if (!grid.isOpen() || (layer.rows() != layout.sizeX()) || (layer.cols() != layout.sizeY()))
+      return false;
+
+    const int size_x = layout.sizeX();
+    const int size_y = layout.sizeY();
+    const int tile_size = TiledLayout::TILE_SIZE;
+
+    if (!grid_map::checkIfIndexInRange(start_index, grid_map::Size(size_x, size_y)))
+      return false;
+
+    for (int tile_y = 0; tile_y < size_y; tile_y += TiledLayout::TILE_SIZE){
+      for (int tile_x = 0; tile_x < size_x; tile_x += TiledLayout::TILE_SIZE){
+        int tile_size_x = std::min(tile_size, size_x - tile_x);
+        int tile_size_y = std::min(tile_size, size_y - tile_y);
+
+        for (int idx_y = tile_y; idx_y < tile_y + tile_size_y; ++idx_y){
+          readWrappedRun(layer, start_index, tile_x, idx_y, tile_size_x, &grid.at(tile_x, idx_y));
+        }
+
+        grid.releaseTile(TiledLayout::tile(layout.index(tile_x, tile_y)));
+      }
+    }
+
+    return true;
+  }
+
+  bool exportMappedLayer(const MappedTiledGrid<float>& grid,
+                         const grid_map::Index& start_index,
+                         grid_map::Matrix& layer)
+  {
+    const TiledLayout& layout (grid.layout());
+
+    if (!grid.isOpen())
+      return false;
+
+    const int size_x = layout.sizeX();
+    const int size_y = layout.sizeY();
+
+    const int tile_size = TiledLayout::TILE_SIZE;
+
+    if (!grid_map::checkIfIndexInRange(start_index, grid_map::Size(size_x, size_y)))
+      return false;
+
+    layer.resize(size_x, size_y);
+
+    for (int tile_y = 0; tile_y < size_y; tile_y += TiledLayout::TILE_SIZE){
+      for (int tile_x = 0; tile_x < size_x; tile_x += TiledLayout::TILE_SIZE){
+        int tile_size_x = std::min(tile_size, size_x - tile_x);
+        int tile_size_y = std::min(tile_size, size_y - tile_y);
+
+        for (int idx_y = tile_y; idx_y < tile_y + tile_size_y; ++idx_y){
+          const float* run = &grid.at(tile_x, idx_y);
+          writeWrappedRun(run, start_index, tile_x, idx_y, tile_size_x, layer);
+        }
+
+        grid.releaseTile(TiledLayout::tile(layout.index(tile_x, tile_y)));
+      }
+    }
+
+    return true;
+  }
+
+  bool buildMappedOccupancyCodes(const MappedTiledGrid<float>& occupancy,
+                                 MappedTiledGrid<unsigned char>& occupancy_codes)
+  {
+    if (!sameSize(occupancy, occupancy_codes))
+      return false;
+
+    const TiledLayout& layout (occupancy.layout());
+
+    const int size_x = layout.sizeX();
+    const int size_y = layout.sizeY();
+
+    for (int tile = 0; tile < layout.numTiles(); ++tile){
+      size_t begin = static_cast<size_t>(tile) * TiledLayout::TILE_CELLS;
+
+      for (size_t index = begin; index < begin + TiledLayout::TILE_CELLS; ++index){
+        grid_map::Index point (layout.cell(static_cast<int>(index)));
+        unsigned char& code = occupancy_codes.data()[index];
+
+        if ((point(0) >= size_x) || (point(1) >= size_y)){
+          code = UNKNOWN_CELL | BORDER_CELL;
+          continue;
+        }
+
+        // NaN compares unequal to both, so it ends up unknown
+        float val = occupancy.data()[index];
+        code = (val == 0.0f) ? FREE_CELL : ((val == 100.0f) ? OCCUPIED_CELL : UNKNOWN_CELL);
+
+        if ((point(0) == 0) || (point(1) == 0) || (point(0) == size_x - 1) || (point(1) == size_y - 1))
+          code |= BORDER_CELL;
+      }
+
+      occupancy.releaseTile(tile);
+      occupancy_codes.releaseTile(tile);
+    }
+
+    return true;
+  }
+
+  bool computeDistanceTransformMapped(const MappedTiledGrid<unsigned char>& occupancy_codes,
+                                      const grid_map::Index& seed_point,
+                                      std::vector<grid_map::Index>& obstacle_cells,
+                                      std::vector<grid_map::Index>& frontier_cells,
+                                      MappedTiledGrid<unsigned char>& cell_state,
+                                      MappedTiledGrid<float>& dist_trans,
+                                      const int max_resident_tiles)
+  {
+    if (!sameSize(occupancy_codes, cell_state) || !sameSize(occupancy_codes, dist_trans))
+      return false;
+
+    const TiledLayout& layout (occupancy_codes.layout());
+
+    obstacle_cells.clear();
+    frontier_cells.clear();
+
+    fillMappedGrid(cell_state, static_cast<unsigned char>(0));
+    fillMappedGrid(dist_trans, std::numeric_limits<float>::max());
+
+    ResidentTiles resident_tiles (layout.numTiles(), max_resident_tiles);
+    resident_tiles.addGrid(occupancy_codes);
+    resident_tiles.addGrid(cell_state);
+    resident_tiles.addGrid(dist_trans);
+
+    const unsigned char* codes = occupancy_codes.data();
+    unsigned char* state = cell_state.data();
+    float* dist_data = dist_trans.data();
+
+    int neighbor_indices[8];
+
+    // Reachability, tile order does not matter for a flood fill
+    {
+      MappedTileQueue tile_queue (layout.numTiles());
+
+      int seed_index = layout.index(seed_point(0), seed_point(1));
+      resident_tiles.touch(TiledLayout::tile(seed_index));
+
+      state[seed_index] = REACHABLE_CELL;
+
+      if (!(codes[seed_index] & BORDER_CELL))
+        tile_queue.push(seed_index, 0.0f);
+
+      while (tile_queue.nextTile()){
+        const int tile = tile_queue.currentTile();
+        resident_tiles.touch(tile);
+
+        int index;
+
+        while (tile_queue.pop(index)){
+          layout.neighbors(index, neighbor_indices);
+
+          for (int i = 0; i < 8; ++i){
+            int neighbor = neighbor_indices[i];
+            touchNeighborTile(resident_tiles, tile, neighbor);
+
+            const unsigned char code = codes[neighbor];
+
+            // Free
+            if ((code & OCCUPANCY_CODE_MASK) == FREE_CELL){
+              if (!(state[neighbor] & REACHABLE_CELL)){
+                state[neighbor] |= REACHABLE_CELL;
+
+                if (!(code & BORDER_CELL))
+                  tile_queue.push(neighbor, 0.0f);
+              }
+            // Occupied
+            }else if ((code & OCCUPANCY_CODE_MASK) == OCCUPIED_CELL){
+              if (!(state[neighbor] & OBSTACLE_CELL)){
+                state[neighbor] |= OBSTACLE_CELL;
+                obstacle_cells.push_back(layout.cell(neighbor));
+              }
+            // Unknown
+            }else{
+              if (!(state[index] & FRONTIER_CELL)){
+                state[index] |= FRONTIER_CELL;
+                frontier_cells.push_back(layout.cell(index));
+              }
+            }
+          }
+        }
+      }
+    }
+
+    MappedTileQueue tile_queue (layout.numTiles());
+
+    for (size_t i = 0; i < obstacle_cells.size(); ++i){
+      int index = layout.index(obstacle_cells[i](0), obstacle_cells[i](1));
+      resident_tiles.touch(TiledLayout::tile(index));
+
+      dist_data[index] = 0.0;
+
+      if (!(codes[index] & BORDER_CELL))
+        tile_queue.push(index, 0.0f);
+    }
+
+    const NeighborOffsets neighbors (layout.sizeX());
+
+    while (tile_queue.nextTile()){
+      const int tile = tile_queue.currentTile();
+      resident_tiles.touch(tile);
+
+      int index;
+
+      while (tile_queue.pop(index)){
+        float current_val = dist_data[index];
+
+        layout.neighbors(index, neighbor_indices);
+
+        for (int i = 0; i < 8; ++i){
+          int neighbor = neighbor_indices[i];
+          touchNeighborTile(resident_tiles, tile, neighbor);
+
+          const unsigned char code = codes[neighbor];
+
+          if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+            continue;
+
+          float cost = current_val + neighbors.costs[i];
+
+          if (dist_data[neighbor] > cost){
+            dist_data[neighbor] = cost;
+
+            if (!(code & BORDER_CELL))
+              tile_queue.push(neighbor, cost);
+          }
+        }
+      }
+    }
+
+    resident_tiles.releaseAll();
+
+    return true;
+  }
+
+  bool computeExplorationTransformMapped(const MappedTiledGrid<unsigned char>& occupancy_codes,
+                                         const MappedTiledGrid<float>& dist_trans,
+                                         const std::vector<grid_map::Index>& goal_points,
+                                         MappedTiledGrid<float>& expl_trans,
+                                         const float lethal_dist,
+                                         const float penalty_dist,
+                                         const int max_resident_tiles,
+                                         ExplorationTransformStats* stats)
+  {
+    if (!sameSize(occupancy_codes, dist_trans) || !sameSize(occupancy_codes, expl_trans))
+      return false;
+
+    const TiledLayout& layout (occupancy_codes.layout());
+
+    fillMappedGrid(expl_trans, std::numeric_limits<float>::max());
+
+    ResidentTiles resident_tiles (layout.numTiles(), max_resident_tiles);
+    resident_tiles.addGrid(occupancy_codes);
+    resident_tiles.addGrid(dist_trans);
+    resident_tiles.addGrid(expl_trans);
+
+    const unsigned char* codes = occupancy_codes.data();
+    float* expl = expl_trans.data();
+
+    const LethalPenaltyCost cost_policy (dist_trans.data(), lethal_dist, penalty_dist);
+    const NeighborOffsets neighbors (layout.sizeX());
+
+    MappedTileQueue tile_queue (layout.numTiles());
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      int index = layout.index(goal_points[i](0), goal_points[i](1));
+      resident_tiles.touch(TiledLayout::tile(index));
+
+      expl[index] = 0.0;
+
+      if (!(codes[index] & BORDER_CELL))
+        tile_queue.push(index, 0.0f);
+    }
+
+    size_t num_pushed = 0;
+
+    int neighbor_indices[8];
+
+    while (tile_queue.nextTile()){
+      const int tile = tile_queue.currentTile();
+      resident_tiles.touch(tile);
+
+      int index;
+
+      while (tile_queue.pop(index)){
+        ++num_pushed;
+
+        float current_val = expl[index];
+
+        layout.neighbors(index, neighbor_indices);
+
+        for (int i = 0; i < 8; ++i){
+          int neighbor = neighbor_indices[i];
+          touchNeighborTile(resident_tiles, tile, neighbor);
+
+          const unsigned char code = codes[neighbor];
+          float cell_cost;
+
+          if (((code & OCCUPANCY_CODE_MASK) != FREE_CELL) || !cost_policy.cellCost(neighbor, cell_cost))
+            continue;
+
+          // Same summation order as touchExplorationCell
+          float cost = (current_val + neighbors.costs[i]) + cell_cost;
+
+          if (expl[neighbor] > cost){
+            expl[neighbor] = cost;
+
+            if (!(code & BORDER_CELL))
+              tile_queue.push(neighbor, cost);
+          }
+        }
+      }
+    }
+
+    resident_tiles.releaseAll();
+
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = 0;
+
+      for (int tile = 0; tile < layout.numTiles(); ++tile){
+        const float* tile_data = expl + static_cast<size_t>(tile) * TiledLayout::TILE_CELLS;
+        stats->settled_cells += TiledLayout::TILE_CELLS - std::count(tile_data, tile_data + TiledLayout::TILE_CELLS, std::numeric_limits<float>::max());
+        expl_trans.releaseTile(tile);
+      }
+    }
+
+    return true;
+  }
+
+} /* namespace */
@@ -1,12 +1,127 @@
 #include <grid_map_proc/grid_map_path_planning.h>
+#include <grid_map_proc/grid_map_transform_policies.h>
 
+#include "grid_map_worker_pool.h"
 
 #include <opencv2/highgui/highgui.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+
 namespace grid_map_path_planning{
   
   
-  bool findPathExplorationTransform(grid_map::GridMap& grid_map,
+  // Same order as the neighbor checks before, first neighbor wins ties
+  const int NEIGHBOR_OFFSETS[8][2] = { {-1, 0}, {0, -1}, {0, 1}, {1, 0}, {-1, -1}, {-1, 1}, {1, -1}, {1, 1} };
+
+  /*
+   * Buffer index of the cell offset_x, offset_y away from index. Works on
+   * circular buffers, returns false if the cell is outside the map.
+   */
+  bool getNeighborIndex(const grid_map::GridMap& grid_map,
+                        const grid_map::Index& index,
+                        const int offset_x,
+                        const int offset_y,
+                        grid_map::Index& neighbor_index)
+  {
+    grid_map::Index unwrapped (grid_map::getIndexFromBufferIndex(index, grid_map.getSize(), grid_map.getStartIndex()));
+
+    unwrapped += grid_map::Index(offset_x, offset_y);
+
+    if (!grid_map::checkIfIndexInRange(unwrapped, grid_map.getSize()))
+      return false;
+
+    neighbor_index = grid_map::getBufferIndexFromIndex(unwrapped, grid_map.getSize(), grid_map.getStartIndex());
+    return true;
+  }
+
+  /*
+   * Follows the steepest descent of expl_data from the start until a goal
+   * (value 0) is reached. Works on float layers and quantized fields laid
+   * out like the layers of grid_map, the start must have a value.
+   */
+  template <class Data>
+  bool descendExplorationTransform(const grid_map::GridMap& grid_map,
+                                   const Data& expl_data,
+                                   const grid_map::Index& start_index,
+                                   std::vector<grid_map::Index>& path_indices)
+  {
+    typedef typename Data::Scalar Scalar;
+
+    grid_map::Index current_index = start_index;
+
+    path_indices.clear();
+    path_indices.push_back(current_index);
+
+    while (expl_data(current_index(0), current_index(1)) != Scalar(0))
+    {
+      const Scalar current_val = expl_data(current_index(0), current_index(1));
+
+      Scalar lowest_val = current_val;
+      grid_map::Index next_index = current_index;
+
+      for (int i = 0; i < 8; ++i){
+        grid_map::Index neighbor_index;
+
+        if (!getNeighborIndex(grid_map, current_index, NEIGHBOR_OFFSETS[i][0], NEIGHBOR_OFFSETS[i][1], neighbor_index))
+          continue;
+
+        // Cells without value hold the largest value, so they never descend
+        if (expl_data(neighbor_index(0), neighbor_index(1)) < lowest_val){
+          lowest_val = expl_data(neighbor_index(0), neighbor_index(1));
+          next_index = neighbor_index;
+        }
+      }
+
+      if (lowest_val == current_val){
+        ROS_WARN("Cannot find gradient");
+        return false;
+      }
+
+      current_index = next_index;
+      path_indices.push_back(current_index);
+    }
+
+    return true;
+  }
+
+  // Poses at the path cells, oriented towards the next one
+  void pathIndicesToPoses(const grid_map::GridMap& grid_map,
+                          const std::vector <grid_map::Index>& path_indices,
+                          std::vector<geometry_msgs::PoseStamped>& path)
+  {
+    path.resize(path_indices.size());
+
+    for (size_t i = 0; i < path_indices.size(); ++i){
+      grid_map::Position position;
+      grid_map.getPosition(path_indices[i], position);
+
+      geometry_msgs::Pose& pose = path[i].pose;
+
+      pose.position.x = position(0);
+      pose.position.y = position(1);
+
+      if (i < (path_indices.size()-1)){
+        // Unwrapped, so steps across the buffer edge of a moved map are short
+        grid_map::Index index (grid_map::getIndexFromBufferIndex(path_indices[i], grid_map.getSize(), grid_map.getStartIndex()));
+        grid_map::Index next_index (grid_map::getIndexFromBufferIndex(path_indices[i+1], grid_map.getSize(), grid_map.getStartIndex()));
+
+        float yaw = std::atan2(index(1)-next_index(1),
+                               index(0)-next_index(0));
+
+        pose.orientation.z = sin(yaw*0.5f);
+        pose.orientation.w = cos(yaw*0.5f);
+      }else if (i > 0){
+        const geometry_msgs::Pose& prior_pose = path[i-1].pose;
+
+        pose.orientation = prior_pose.orientation;
+      }
+
+    }
+  }
+
+  bool findPathExplorationTransform(const grid_map::GridMap& grid_map,
                                     const geometry_msgs::Pose& start_pose,
                                     std::vector<geometry_msgs::PoseStamped>& path,
                                     float* path_cost,
@@ -15,10 +130,9 @@ namespace grid_map_path_planning{
                                     const std::string expl_trans_layer)
   {
 
-    grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
+    const grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
 
     grid_map::Index current_index;
-    grid_map::Index next_index;
 
     if (!grid_map.getIndex(grid_map::Position(start_pose.position.x, start_pose.position.y),current_index)){
       ROS_WARN("Start index not in map");
@@ -30,159 +144,674 @@ namespace grid_map_path_planning{
       return false;
     }
 
+    if (path_cost){
+      *path_cost = expl_data(current_index(0), current_index(1));
+    }
+
     std::vector <grid_map::Index> path_indices;
-    path_indices.push_back(current_index);
 
-    // Cost can be looked up from start pose
-    //float path_cost_sum;
+    if (!descendExplorationTransform(grid_map, expl_data, current_index, path_indices))
+      return false;
+
+    std::vector <grid_map::Index> refined_path_indices;
+
+    shortCutPath(grid_map, path_indices, refined_path_indices, dist_trans_layer, expl_trans_layer);
+
+    pathIndicesToPoses(grid_map, refined_path_indices, path);
 
+    return true;
+  }
+
+  bool findPathExplorationTransform(const grid_map::GridMap& grid_map,
+                                    const grid_map_transforms::QuantizedField& expl_field,
+                                    const grid_map_transforms::QuantizedField& dist_field,
+                                    const geometry_msgs::Pose& start_pose,
+                                    std::vector<geometry_msgs::PoseStamped>& path,
+                                    float* path_cost)
+  {
+    grid_map::Index current_index;
 
-    //geometry_msgs::PoseStamped trajPoint;
-    //std::string global_frame = costmap_ros_->getGlobalFrameID();
-    //trajPoint.header.frame_id = global_frame;
+    if (!grid_map.getIndex(grid_map::Position(start_pose.position.x, start_pose.position.y),current_index)){
+      ROS_WARN("Start index not in map");
+      return false;
+    }
 
-    //std::cout << "\nStart curr_index:\n" << current_index << "\nval: " << expl_data(current_index(0), current_index(1)) << "\n";
+    if ((expl_field.data.rows() != grid_map.getSize()(0)) || (expl_field.data.cols() != grid_map.getSize()(1))){
+      ROS_WARN("Exploration transform does not match map size");
+      return false;
+    }
 
-    grid_map::Matrix& dist_data = grid_map[dist_trans_layer];
+    if (expl_field.data(current_index(0), current_index(1)) == grid_map_transforms::QUANTIZED_UNREACHED){
+      ROS_WARN("Start index not in exploration transform");
+      return false;
+    }
 
     if (path_cost){
-      *path_cost = expl_data(current_index(0), current_index(1));
+      *path_cost = expl_field.value(current_index(0), current_index(1));
+    }
+
+    std::vector <grid_map::Index> path_indices;
+
+    if (!descendExplorationTransform(grid_map, expl_field.data, current_index, path_indices))
+      return false;
+
+    std::vector <grid_map::Index> refined_path_indices;
+
+    shortCutPath(grid_map, dist_field, path_indices, refined_path_indices);
+
+    pathIndicesToPoses(grid_map, refined_path_indices, path);
+
+    return true;
+  }
+
+  bool findPathsExplorationTransform(const grid_map::GridMap& grid_map,
+                                     const std::vector<geometry_msgs::Pose>& start_poses,
+                                     std::vector<float>& path_costs,
+                                     std::vector<std::vector<geometry_msgs::PoseStamped> >* paths,
+                                     const int num_threads,
+                                     const std::string dist_trans_layer,
+                                     const std::string expl_trans_layer)
+  {
+    if (!grid_map.exists(expl_trans_layer) || (paths && !grid_map.exists(dist_trans_layer)))
+      return false;
+
+    const grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
+
+    const size_t num_starts = start_poses.size();
+
+    path_costs.assign(num_starts, std::numeric_limits<float>::max());
+
+    if (paths){
+      paths->clear();
+      paths->resize(num_starts);
+    }
+
+    // Starts are handed out one at a time, path lengths differ a lot
+    std::atomic<size_t> next_start (0);
+
+    auto extract_paths = [&](int){
+      std::vector <grid_map::Index> path_indices;
+      std::vector <grid_map::Index> refined_path_indices;
+
+      size_t i;
+
+      while ((i = next_start.fetch_add(1)) < num_starts){
+        grid_map::Index start_index;
+
+        if (!grid_map.getIndex(grid_map::Position(start_poses[i].position.x, start_poses[i].position.y), start_index))
+          continue;
+
+        const float start_cost = expl_data(start_index(0), start_index(1));
+
+        if (start_cost == std::numeric_limits<float>::max())
+          continue;
+
+        if (paths){
+          if (!descendExplorationTransform(grid_map, expl_data, start_index, path_indices))
+            continue;
+
+          refined_path_indices.clear();
+          shortCutPath(grid_map, path_indices, refined_path_indices, dist_trans_layer, expl_trans_layer);
+
+          pathIndicesToPoses(grid_map, refined_path_indices, (*paths)[i]);
+        }
+
+        path_costs[i] = start_cost;
+      }
+    };
+
+    // Costs alone are one read per start, not worth starting threads
+    const size_t num_workers = paths ? std::max(1, std::min(num_threads, static_cast<int>(num_starts))) : 1;
+
+    // Same threads as the parallel transforms, kept between calls
+    grid_map_transforms::WorkerPool::shared().run(num_workers, extract_paths);
+
+    return true;
+  }
+
+  /*
+   * Continuous coordinates of the map: unwrapped cell indices, with cell
+   * centers at integer values. Positions are affine in them.
+   */
+  class ContinuousIndexFrame
+  {
+  public:
+    explicit ContinuousIndexFrame(const grid_map::GridMap& grid_map)
+      : grid_map_(grid_map)
+    {
+      origin_ = cellPosition(grid_map::Index(0, 0));
+      axis_x_ = cellPosition(grid_map::Index(1, 0)) - origin_;
+      axis_y_ = cellPosition(grid_map::Index(0, 1)) - origin_;
     }
 
+    Eigen::Vector2d toIndex(const grid_map::Position& position) const
+    {
+      grid_map::Position offset (position - origin_);
+      return Eigen::Vector2d(offset.dot(axis_x_) / axis_x_.squaredNorm(),
+                             offset.dot(axis_y_) / axis_y_.squaredNorm());
+    }
 
-    while(!expl_data(current_index(0), current_index(1)) == 0.0)
+    grid_map::Position toPosition(const Eigen::Vector2d& index) const
     {
+      return origin_ + index(0) * axis_x_ + index(1) * axis_y_;
+    }
 
-      // We guarantee in construction of expl. transform that we're not
-      // at the border.
-      //if (point(0) < 1 || point(0) >= size_x_lim ||
-      //    point(1) < 1 || point(1) >= size_y_lim){
-      //    continue;
-      //}
-
-      //std::cout << "\nStartloop curr_index:\n" << current_index << "\nval: " << expl_data(current_index(0), current_index(1)) << "\n";
-
-
-
-      float lowest_cost = std::numeric_limits<float>::min();
-
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1),
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0),
-                             current_index(1)-1,
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0),
-                             current_index(1)+1,
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1),
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1)-1,
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1)+1,
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1)-1,
-                             lowest_cost,
-                             next_index);
-
-      touchGradientCell(expl_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1)+1,
-                             lowest_cost,
-                             next_index);
-
-
-      //std::cout << "\ncurr_index:\n" << current_index << "\nval: " << expl_data(current_index(0), current_index(1)) << "\n";
-
-      if (lowest_cost == std::numeric_limits<float>::min()){
-        ROS_WARN("Cannot find gradient");
+    // Buffer index of the unwrapped cell, false if outside the map
+    bool bufferIndex(const int idx_x,
+                     const int idx_y,
+                     grid_map::Index& buffer_index) const
+    {
+      grid_map::Index index (idx_x, idx_y);
+
+      if (!grid_map::checkIfIndexInRange(index, grid_map_.getSize()))
+        return false;
+
+      buffer_index = grid_map::getBufferIndexFromIndex(index, grid_map_.getSize(), grid_map_.getStartIndex());
+      return true;
+    }
+
+  protected:
+    grid_map::Position cellPosition(const grid_map::Index& index) const
+    {
+      grid_map::Position position;
+      grid_map_.getPosition(grid_map::getBufferIndexFromIndex(index, grid_map_.getSize(), grid_map_.getStartIndex()), position);
+      return position;
+    }
+
+    const grid_map::GridMap& grid_map_;
+    grid_map::Position origin_;
+    grid_map::Position axis_x_;
+    grid_map::Position axis_y_;
+  };
+
+  /*
+   * Bilinear interpolation of expl_data and its gradient at a continuous
+   * index. False if one of the four surrounding cells has no value.
+   */
+  bool interpolateExplorationTransform(const ContinuousIndexFrame& frame,
+                                       const grid_map::Matrix& expl_data,
+                                       const Eigen::Vector2d& point,
+                                       float& value,
+                                       Eigen::Vector2d& gradient)
+  {
+    int idx_x = static_cast<int>(std::floor(point(0)));
+    int idx_y = static_cast<int>(std::floor(point(1)));
+
+    // Points on the last row or column use the cells before them
+    idx_x = std::min(idx_x, static_cast<int>(expl_data.rows()) - 2);
+    idx_y = std::min(idx_y, static_cast<int>(expl_data.cols()) - 2);
+
+    float corners[2][2];
+
+    for (int x = 0; x < 2; ++x){
+      for (int y = 0; y < 2; ++y){
+        grid_map::Index index;
+
+        if (!frame.bufferIndex(idx_x + x, idx_y + y, index))
+          return false;
+
+        corners[x][y] = expl_data(index(0), index(1));
+
+        if (corners[x][y] == std::numeric_limits<float>::max())
+          return false;
+      }
+    }
+
+    double fx = point(0) - idx_x;
+    double fy = point(1) - idx_y;
+
+    double low = corners[0][0] + fx * (corners[1][0] - corners[0][0]);
+    double high = corners[0][1] + fx * (corners[1][1] - corners[0][1]);
+
+    value = static_cast<float>(low + fy * (high - low));
+
+    gradient(0) = (1.0 - fy) * (corners[1][0] - corners[0][0]) + fy * (corners[1][1] - corners[0][1]);
+    gradient(1) = high - low;
+
+    return true;
+  }
+
+  // True if the cells along the segment from start to end have values
+  bool interpolatedSegmentClear(const ContinuousIndexFrame& frame,
+                                const grid_map::Matrix& expl_data,
+                                const Eigen::Vector2d& start,
+                                const Eigen::Vector2d& end)
+  {
+    int num_samples = static_cast<int>(std::ceil((end - start).norm() / 0.5));
+
+    for (int i = 1; i < num_samples; ++i){
+      Eigen::Vector2d sample (start + (end - start) * (static_cast<double>(i) / num_samples));
+
+      grid_map::Index index;
+
+      if (!frame.bufferIndex(static_cast<int>(std::floor(sample(0) + 0.5)),
+                             static_cast<int>(std::floor(sample(1) + 0.5)),
+                             index) ||
+          (expl_data(index(0), index(1)) == std::numeric_limits<float>::max())){
         return false;
       }
+    }
 
-      current_index = next_index;
+    return true;
+  }
+
+  bool findPathExplorationTransformInterpolated(const grid_map::GridMap& grid_map,
+                                                const geometry_msgs::Pose& start_pose,
+                                                std::vector<geometry_msgs::PoseStamped>& path,
+                                                const float step_length,
+                                                float* path_cost,
+                                                const std::string expl_trans_layer)
+  {
+    const grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
 
-      //if ((dist_data(current_index(0), current_index(1)) < 12.0) || expl_data(current_index(0), current_index(1)) == 0.0){
-      //  path_indices.push_back(current_index);
-      //  std::cout << "add: " << dist_data(current_index(0), current_index(1)) << "\n";
-      //}else{
-      //  std::cout << "rem: " << dist_data(current_index(0), current_index(1)) << "\n";
-      //}
+    if ((expl_data.rows() < 2) || (expl_data.cols() < 2) || !(step_length > 0.0f))
+      return false;
 
-      path_indices.push_back(current_index);
+    grid_map::Position start_position (start_pose.position.x, start_pose.position.y);
+    grid_map::Index current_index;
+
+    if (!grid_map.getIndex(start_position, current_index)){
+      ROS_WARN("Start index not in map");
+      return false;
     }
 
-    //std::cout << "current_index after path gen: " << current_index << "\n";
+    float current_val = expl_data(current_index(0), current_index(1));
 
-    if (path_indices.size() == 1)
-    {
-      //Already at start
+    if (current_val == std::numeric_limits<float>::max()){
+      ROS_WARN("Start index not in exploration transform");
+      return false;
     }
 
-    std::vector <grid_map::Index> refined_path_indices;
+    if (path_cost){
+      *path_cost = current_val;
+    }
 
-    shortCutPath(grid_map, path_indices, refined_path_indices);
+    const ContinuousIndexFrame frame (grid_map);
 
-    path_indices = refined_path_indices;
+    // Integration step, waypoints are emitted every step_length
+    const double sub_step = std::min(step_length, 0.5f);
 
-    //path.header.frame_id = "map";
-    //path.header.stamp = ros::Time::now();
-    path.resize(path_indices.size());
+    // The transform falls by at least 0.955 per cell along the descent,
+    // gradient steps must achieve a quarter of that
+    const float required_decrease = 0.25f * 0.955f * sub_step;
 
-    for (size_t i = 0; i < path_indices.size(); ++i){
-      grid_map::Position position;
-      grid_map.getPosition(path_indices[i], position);
+    Eigen::Vector2d point (frame.toIndex(start_position));
+    Eigen::Vector2d last_waypoint (point);
+    Eigen::Vector2d previous_point (point);
+
+    std::vector<Eigen::Vector2d> waypoints(1, point);
+
+    // Every step lowers the interpolated value or the value of the cell
+    size_t max_steps = static_cast<size_t>(2.0f * current_val / required_decrease) +
+                       2 * static_cast<size_t>(expl_data.rows() + expl_data.cols());
+
+    for (size_t step = 0; current_val != 0.0f; ++step){
+      if (step > max_steps){
+        ROS_WARN("Interpolated descent did not converge");
+        return false;
+      }
+
+      Eigen::Vector2d next_point;
+      bool gradient_step = false;
+
+      float point_val;
+      Eigen::Vector2d gradient;
+
+      if (interpolateExplorationTransform(frame, expl_data, point, point_val, gradient) &&
+          (gradient.squaredNorm() > 0.0)){
+        next_point = point - (sub_step / gradient.norm()) * gradient;
+
+        float next_val;
+        Eigen::Vector2d next_gradient;
+
+        gradient_step = interpolateExplorationTransform(frame, expl_data, next_point, next_val, next_gradient) &&
+                        (next_val <= point_val - required_decrease);
+      }
+
+      // Near obstacles, unreached cells or flat spots, step to the lowest
+      // neighbor cell like descendExplorationTransform
+      if (!gradient_step){
+        grid_map::Index unwrapped (grid_map::getIndexFromBufferIndex(current_index, grid_map.getSize(), grid_map.getStartIndex()));
+
+        float lowest_val = current_val;
+        grid_map::Index lowest_unwrapped (unwrapped);
+
+        for (int i = 0; i < 8; ++i){
+          grid_map::Index neighbor_index;
+
+          if (!frame.bufferIndex(unwrapped(0) + NEIGHBOR_OFFSETS[i][0], unwrapped(1) + NEIGHBOR_OFFSETS[i][1], neighbor_index))
+            continue;
+
+          if (expl_data(neighbor_index(0), neighbor_index(1)) < lowest_val){
+            lowest_val = expl_data(neighbor_index(0), neighbor_index(1));
+            lowest_unwrapped = unwrapped + grid_map::Index(NEIGHBOR_OFFSETS[i][0], NEIGHBOR_OFFSETS[i][1]);
+          }
+        }
+
+        if (lowest_val == current_val){
+          ROS_WARN("Cannot find gradient");
+          return false;
+        }
+
+        next_point = Eigen::Vector2d(lowest_unwrapped(0), lowest_unwrapped(1));
+      }
+
+      point = next_point;
+
+      grid_map::Index nearest_index;
+
+      if (!frame.bufferIndex(static_cast<int>(std::floor(point(0) + 0.5)),
+                             static_cast<int>(std::floor(point(1) + 0.5)),
+                             nearest_index)){
+        ROS_WARN("Interpolated descent left the map");
+        return false;
+      }
+
+      current_index = nearest_index;
+      current_val = expl_data(current_index(0), current_index(1));
+
+      if (current_val == std::numeric_limits<float>::max()){
+        ROS_WARN("Interpolated descent left the exploration transform");
+        return false;
+      }
+
+      // Waypoints are only skipped while the straight path between them
+      // stays on cells with values
+      if ((previous_point != last_waypoint) && !interpolatedSegmentClear(frame, expl_data, last_waypoint, point)){
+        waypoints.push_back(previous_point);
+        last_waypoint = previous_point;
+      }
+
+      if ((point - last_waypoint).norm() >= step_length){
+        waypoints.push_back(point);
+        last_waypoint = point;
+      }
+
+      previous_point = point;
+    }
+
+    // End at the goal cell
+    grid_map::Index goal (grid_map::getIndexFromBufferIndex(current_index, grid_map.getSize(), grid_map.getStartIndex()));
+    Eigen::Vector2d goal_point (goal(0), goal(1));
+
+    if (!interpolatedSegmentClear(frame, expl_data, last_waypoint, goal_point) && (last_waypoint != point))
+      waypoints.push_back(point);
+
+    if (waypoints.back() != goal_point)
+      waypoints.push_back(goal_point);
+
+    path.resize(waypoints.size());
+
+    for (size_t i = 0; i < waypoints.size(); ++i){
+      grid_map::Position position (frame.toPosition(waypoints[i]));
 
       geometry_msgs::Pose& pose = path[i].pose;
 
       pose.position.x = position(0);
       pose.position.y = position(1);
 
-      if (i < (path_indices.size()-1)){
-        float yaw = std::atan2(path_indices[i](1)-path_indices[i+1](1),
-                               path_indices[i](0)-path_indices[i+1](0));
+      if (i < (waypoints.size()-1)){
+        grid_map::Position next_position (frame.toPosition(waypoints[i+1]));
+
+        float yaw = std::atan2(next_position(1) - position(1),
+                               next_position(0) - position(0));
 
         pose.orientation.z = sin(yaw*0.5f);
         pose.orientation.w = cos(yaw*0.5f);
-      }else{
-        const geometry_msgs::Pose& prior_pose = path[i-1].pose;
+      }else if (i > 0){
+        pose.orientation = path[i-1].pose.orientation;
+      }
+    }
 
-        pose.orientation = prior_pose.orientation;
+    return true;
+  }
+
+  bool findPathThetaStar(const grid_map::GridMap& grid_map,
+                         const geometry_msgs::Pose& start_pose,
+                         const geometry_msgs::Pose& goal_pose,
+                         std::vector<geometry_msgs::PoseStamped>& path,
+                         float* path_cost,
+                         const float lethal_dist,
+                         const float penalty_dist,
+                         const std::string dist_trans_layer,
+                         grid_map_transforms::ExplorationTransformStats* stats,
+                         ThetaStarWorkspace* workspace)
+  {
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    ThetaStarWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    const grid_map::Matrix& dist_data = grid_map[dist_trans_layer];
+
+    grid_map::Index start_index;
+    grid_map::Index goal_index;
+
+    if (!grid_map.getIndex(grid_map::Position(start_pose.position.x, start_pose.position.y), start_index)){
+      ROS_WARN("Start index not in map");
+      return false;
+    }
+
+    if (!grid_map.getIndex(grid_map::Position(goal_pose.position.x, goal_pose.position.y), goal_index)){
+      ROS_WARN("Goal index not in map");
+      return false;
+    }
+
+    const grid_map::Size& size (grid_map.getSize());
+    const grid_map::Index& buffer_start_index (grid_map.getStartIndex());
+    const int size_x = size(0);
+    const int size_y = size(1);
+
+    // The search runs on unwrapped cells (x + y * size_x), so neighbors and
+    // lengths are those in the map. Buffer rows and columns of unwrapped
+    // ones are looked up.
+    std::vector<int>& buffer_x (workspace->buffer_x);
+    std::vector<int>& buffer_y (workspace->buffer_y);
+
+    buffer_x.resize(size_x);
+    buffer_y.resize(size_y);
+
+    for (int x = 0; x < size_x; ++x){
+      buffer_x[x] = (x + buffer_start_index(0)) % size_x;
+    }
+
+    for (int y = 0; y < size_y; ++y){
+      buffer_y[y] = (y + buffer_start_index(1)) % size_y;
+    }
+
+    const float* dist = dist_data.data();
+
+    const grid_map::Index start_point (grid_map::getIndexFromBufferIndex(start_index, size, buffer_start_index));
+    const grid_map::Index goal_point (grid_map::getIndexFromBufferIndex(goal_index, size, buffer_start_index));
+
+    const int start_cell = start_point(0) + start_point(1) * size_x;
+    const int goal_cell = goal_point(0) + goal_point(1) * size_x;
+
+    // Distances are looked up in the buffer, which the cost policy indexes
+    const grid_map_transforms::LethalPenaltyCost cell_cost (dist_data, lethal_dist, penalty_dist);
+
+    float start_cost;
+    float goal_cost;
+
+    if ((dist_data(start_index(0), start_index(1)) == std::numeric_limits<float>::max()) ||
+        !cell_cost.cellCost(start_index(0) + start_index(1) * size_x, start_cost)){
+      ROS_WARN("Start index too close to obstacles or without distance");
+      return false;
+    }
+
+    if ((dist_data(goal_index(0), goal_index(1)) == std::numeric_limits<float>::max()) ||
+        !cell_cost.cellCost(goal_index(0) + goal_index(1) * size_x, goal_cost)){
+      ROS_WARN("Goal index too close to obstacles or without distance");
+      return false;
+    }
+
+    // Straight lines must not enter penalized cells, so their cost is the
+    // step cost along them. The heuristic is the straight line to the goal.
+    const float line_clearance = std::max(lethal_dist, penalty_dist);
+    const float line_step_cost = 0.955f;
+
+    const int num_cells = size_x * size_y;
+
+    // A new generation invalidates the state of earlier queries, stamps are
+    // only reset when it wraps around
+    if (workspace->visited.size() != static_cast<size_t>(num_cells)){
+      workspace->cost_from_start.resize(num_cells);
+      workspace->parents.resize(num_cells);
+      workspace->visited.assign(num_cells, 0);
+      workspace->closed.assign(num_cells, 0);
+      workspace->generation = 0;
+    }
+
+    if (++workspace->generation == 0){
+      std::fill(workspace->visited.begin(), workspace->visited.end(), 0);
+      std::fill(workspace->closed.begin(), workspace->closed.end(), 0);
+      workspace->generation = 1;
+    }
+
+    const unsigned int generation = workspace->generation;
+
+    std::vector<float>& cost_from_start (workspace->cost_from_start);
+    std::vector<int>& parents (workspace->parents);
+    std::vector<unsigned int>& visited (workspace->visited);
+    std::vector<unsigned int>& closed (workspace->closed);
+
+    std::vector<ThetaStarWorkspace::Node>& open_cells (workspace->open_cells);
+    const std::greater<ThetaStarWorkspace::Node> open_compare;
+
+    open_cells.clear();
+
+    cost_from_start[start_cell] = 0.0f;
+    parents[start_cell] = start_cell;
+    visited[start_cell] = generation;
+
+    ThetaStarWorkspace::Node start_node = { line_step_cost * static_cast<float>(std::hypot(start_point(0) - goal_point(0), start_point(1) - goal_point(1))), start_cell };
+    open_cells.push_back(start_node);
+
+    size_t num_pushed = 1;
+    size_t num_settled = 0;
+
+    while (!open_cells.empty()){
+      std::pop_heap(open_cells.begin(), open_cells.end(), open_compare);
+      const int cell = open_cells.back().cell;
+      open_cells.pop_back();
+
+      // Cells are pushed again when improved, later entries are stale
+      if (closed[cell] == generation)
+        continue;
+
+      closed[cell] = generation;
+      ++num_settled;
+
+      const int x = cell % size_x;
+      const int y = cell / size_x;
+
+      // Lines of sight are assumed when pushing and checked here, once per
+      // cell. If blocked, the cell is reached from its best settled
+      // neighbor instead, there is at least the one that pushed it.
+      const int line_start = parents[cell];
+
+      if (!grid_map_transforms::isRayClear(dist_data,
+                                           buffer_start_index,
+                                           grid_map::Index(buffer_x[line_start % size_x], buffer_y[line_start / size_x]),
+                                           grid_map::Index(buffer_x[x], buffer_y[y]),
+                                           line_clearance,
+                                           true)){
+        float cell_penalty = 0.0f;
+        cell_cost.cellCost(buffer_x[x] + buffer_y[y] * size_x, cell_penalty);
+
+        cost_from_start[cell] = std::numeric_limits<float>::max();
+
+        for (int i = 0; i < 8; ++i){
+          const int neighbor_x = x + NEIGHBOR_OFFSETS[i][0];
+          const int neighbor_y = y + NEIGHBOR_OFFSETS[i][1];
+
+          if ((neighbor_x < 0) || (neighbor_x >= size_x) || (neighbor_y < 0) || (neighbor_y >= size_y))
+            continue;
+
+          const int neighbor_cell = neighbor_x + neighbor_y * size_x;
+
+          if (closed[neighbor_cell] != generation)
+            continue;
+
+          const float cost = cost_from_start[neighbor_cell] + ((i < 4) ? 0.955f : 1.3693f) + cell_penalty;
+
+          if (cost < cost_from_start[cell]){
+            cost_from_start[cell] = cost;
+            parents[cell] = neighbor_cell;
+          }
+        }
+      }
+
+      if (cell == goal_cell)
+        break;
+
+      const int parent_cell = parents[cell];
+      const int parent_x = parent_cell % size_x;
+      const int parent_y = parent_cell / size_x;
+      const float parent_cost = cost_from_start[parent_cell];
+
+      for (int i = 0; i < 8; ++i){
+        const int neighbor_x = x + NEIGHBOR_OFFSETS[i][0];
+        const int neighbor_y = y + NEIGHBOR_OFFSETS[i][1];
+
+        if ((neighbor_x < 0) || (neighbor_x >= size_x) || (neighbor_y < 0) || (neighbor_y >= size_y))
+          continue;
+
+        const int neighbor_cell = neighbor_x + neighbor_y * size_x;
+        const int neighbor_buffer_cell = buffer_x[neighbor_x] + buffer_y[neighbor_y] * size_x;
+
+        float neighbor_penalty;
+
+        if ((closed[neighbor_cell] == generation) ||
+            (dist[neighbor_buffer_cell] == std::numeric_limits<float>::max()) ||
+            !cell_cost.cellCost(neighbor_buffer_cell, neighbor_penalty))
+          continue;
+
+        const float cost = parent_cost + line_step_cost * std::sqrt(static_cast<float>((neighbor_x - parent_x) * (neighbor_x - parent_x) +
+                                                                                      (neighbor_y - parent_y) * (neighbor_y - parent_y))) + neighbor_penalty;
+
+        if ((visited[neighbor_cell] != generation) || (cost < cost_from_start[neighbor_cell])){
+          cost_from_start[neighbor_cell] = cost;
+          parents[neighbor_cell] = parent_cell;
+          visited[neighbor_cell] = generation;
+
+          ThetaStarWorkspace::Node node = { cost + line_step_cost * std::sqrt(static_cast<float>((neighbor_x - goal_point(0)) * (neighbor_x - goal_point(0)) +
+                                                                                      (neighbor_y - goal_point(1)) * (neighbor_y - goal_point(1)))), neighbor_cell };
+          open_cells.push_back(node);
+          std::push_heap(open_cells.begin(), open_cells.end(), open_compare);
+          ++num_pushed;
+        }
       }
+    }
 
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = num_settled;
     }
 
+    if (closed[goal_cell] != generation){
+      ROS_WARN("Goal not reachable from start");
+      return false;
+    }
+
+    if (path_cost){
+      *path_cost = cost_from_start[goal_cell];
+    }
+
+    std::vector <grid_map::Index> path_indices;
+
+    for (int cell = goal_cell; cell != start_cell; cell = parents[cell]){
+      path_indices.push_back(grid_map::Index(buffer_x[cell % size_x], buffer_y[cell / size_x]));
+    }
+
+    path_indices.push_back(start_index);
+    std::reverse(path_indices.begin(), path_indices.end());
+
+    pathIndicesToPoses(grid_map, path_indices, path);
+
     return true;
   }
 
@@ -211,12 +840,19 @@ namespace grid_map_path_planning{
       grid_map::Index adjusted_index;
 
 
-      findValidClosePoseExplorationTransform(grid_map,
-                                             current_index,
-                                             adjusted_index,
-                                             3.0,
-                                             6.0,
-                                             6.0);
+      // Far enough to get from an obstacle to the required distance
+      if (!findValidClosePoseExplorationTransform(grid_map,
+                                                  current_index,
+                                                  adjusted_index,
+                                                  8.0,
+                                                  6.0,
+                                                  6.0,
+                                                  occupancy_layer,
+                                                  dist_trans_layer,
+                                                  expl_trans_layer)){
+        ROS_WARN("No valid pose close to start pose, not adjusting");
+        return false;
+      }
 
       grid_map::Position adjusted_position;
 
@@ -232,6 +868,28 @@ namespace grid_map_path_planning{
     return true;
   }
 
+  // Cell of the close pose search, offsets are from the start cell
+  struct ClosePoseCandidate
+  {
+    float dist;
+    int offset_x;
+    int offset_y;
+
+    int squaredOffset() const { return offset_x * offset_x + offset_y * offset_y; }
+  };
+
+  // Highest distance first, the one closer to the start on ties
+  struct ClosePoseCandidateCompare
+  {
+    bool operator()(const ClosePoseCandidate& a, const ClosePoseCandidate& b) const
+    {
+      if (a.dist != b.dist)
+        return a.dist < b.dist;
+
+      return a.squaredOffset() > b.squaredOffset();
+    }
+  };
+
   bool findValidClosePoseExplorationTransform(const grid_map::GridMap& grid_map,
                           const grid_map::Index& start_index,
                           grid_map::Index& adjusted_index,
@@ -240,231 +898,190 @@ namespace grid_map_path_planning{
                           const float desired_final_distance,
                           const std::string occupancy_layer,
                           const std::string dist_trans_layer,
-                          const std::string expl_trans_layer)
+                          const std::string expl_trans_layer,
+                          const int max_expanded_cells)
   {
-    //grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
-
-    grid_map::Index current_index;
-    grid_map::Index next_index;
-
-    //if (!grid_map.getIndex(grid_map::Position(start_index[0], start_index[1]),current_index)){
-    //  ROS_WARN("Start index not in map");
-    //  return false;
-    //}
-
-    current_index = start_index;
-
-    //if (expl_data(current_index(0), current_index(1)) == std::numeric_limits<float>::max()){
-    //  ROS_WARN("Start index not in exploration transform");
-    //  return false;
-    //}
-
-    std::vector <grid_map::Index> path_indices;
-    path_indices.push_back(current_index);
-
-    // Cost can be looked up from start pose
-    //float path_cost_sum;
-
-
-    //geometry_msgs::PoseStamped trajPoint;
-    //std::string global_frame = costmap_ros_->getGlobalFrameID();
-    //trajPoint.header.frame_id = global_frame;
-
-    //std::cout << "\nStart curr_index:\n" << current_index << "\nval: " << expl_data(current_index(0), current_index(1)) << "\n";
-
     const grid_map::Matrix& dist_data = grid_map[dist_trans_layer];
 
-    float dist_from_start = 0.0f;
+    adjusted_index = start_index;
 
-
-    float dist_from_obstacle = dist_data(current_index(0), current_index(1));
-
-    if (dist_from_obstacle >= desired_final_distance){
+    if (dist_data(start_index(0), start_index(1)) >= desired_final_distance){
       ROS_INFO("Pose already farther than desired distance from next obstacle, not modifying");
-      adjusted_index = start_index;
       return true;
     }
 
+    // Visited cells of the square around the start holding the search radius
+    const int radius = std::max(0, static_cast<int>(std::floor(allowed_distance_from_start)));
+    const int width = 2 * radius + 1;
+    const float squared_radius = allowed_distance_from_start * allowed_distance_from_start;
 
-    bool abort = false;
-
-    while(!abort)
-    {
-
-      // We guarantee in construction of expl. transform that we're not
-      // at the border.
-      //if (point(0) < 1 || point(0) >= size_x_lim ||
-      //    point(1) < 1 || point(1) >= size_y_lim){
-      //    continue;
-      //}
-
-      //std::cout << "\nStartloop curr_index:\n" << current_index << "\nval: " << expl_data(current_index(0), current_index(1)) << "\n";
-
-
-
-      float highest_cost = 0.0f;
-
+    std::vector<unsigned char> visited (width * width, 0);
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1),
-                             highest_cost,
-                             next_index);
+    std::priority_queue<ClosePoseCandidate, std::vector<ClosePoseCandidate>, ClosePoseCandidateCompare> queue;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0),
-                             current_index(1)-1,
-                             highest_cost,
-                             next_index);
+    ClosePoseCandidate start = { dist_data(start_index(0), start_index(1)), 0, 0 };
+    queue.push(start);
+    visited[radius * width + radius] = 1;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0),
-                             current_index(1)+1,
-                             highest_cost,
-                             next_index);
+    ClosePoseCandidate best = start;
+    int num_expanded = 0;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1),
-                             highest_cost,
-                             next_index);
+    while (!queue.empty() && (num_expanded < max_expanded_cells)){
+      const ClosePoseCandidate current = queue.top();
+      queue.pop();
+      ++num_expanded;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1)-1,
-                             highest_cost,
-                             next_index);
+      if (ClosePoseCandidateCompare()(best, current))
+        best = current;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)-1,
-                             current_index(1)+1,
-                             highest_cost,
-                             next_index);
+      if (current.dist >= desired_final_distance)
+        break;
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1)-1,
-                             highest_cost,
-                             next_index);
+      for (int i = 0; i < 8; ++i){
+        const int offset_x = current.offset_x + NEIGHBOR_OFFSETS[i][0];
+        const int offset_y = current.offset_y + NEIGHBOR_OFFSETS[i][1];
 
-      touchDistanceField(dist_data,
-                             current_index,
-                             current_index(0)+1,
-                             current_index(1)+1,
-                             highest_cost,
-                             next_index);
+        if ((offset_x * offset_x + offset_y * offset_y) > squared_radius)
+          continue;
 
+        unsigned char& neighbor_visited = visited[(offset_y + radius) * width + offset_x + radius];
 
-      dist_from_obstacle = dist_data(current_index(0), current_index(1));
+        if (neighbor_visited)
+          continue;
 
-      //std::cout << "curr_index: " << current_index << "\ndist_from_obstacle: " << dist_from_obstacle << "dist_from_start: " << dist_from_start << " highest cost: " << highest_cost << "\n";
+        neighbor_visited = 1;
 
-      // If gradient could not be followed..
-      if (highest_cost == 0.0f){
+        grid_map::Index neighbor_index;
 
-        //std::cout << "curr_index: " << current_index << "\nval: " << dist_data(current_index(0), current_index(1)) << "dist_from_start: " << dist_from_start << " highest cost: " << highest_cost << "\n";
+        if (!getNeighborIndex(grid_map, start_index, offset_x, offset_y, neighbor_index))
+          continue;
 
-        //ROS_INFO_STREAM("Reached end of distance transform with dist_from_start)
-
-        // Could not reach enough clearance
-        if (dist_from_obstacle < required_final_distance){
-          ROS_WARN("Could not find gradient of distance transform leading to free area, returning original pose");
-          adjusted_index = start_index;
-          return false;
-
-        // Could not reach desired distance from obstacles, but enough clearance
-        }else if (dist_from_obstacle < desired_final_distance){
-          ROS_WARN("Could not find gradient of distance transform reaching desired final distance");
-          abort = true;
-
-        }else{
-          ROS_INFO("Reached final distance");
-          abort = true;
-        }
+        const float neighbor_dist = dist_data(neighbor_index(0), neighbor_index(1));
 
-      // Gradient following worked
-      }else{
+        // Never through obstacles or cells without distance
+        if ((neighbor_dist <= 0.0f) || (neighbor_dist == std::numeric_limits<float>::max()))
+          continue;
 
-        //dist_from_start += highest_cost;
-
-        // If desired distance exceeded, stop here
-        if (dist_from_obstacle > desired_final_distance){
-          abort = true;
-
-        // Otherwise continue gradient following
-        }else{
-
-          current_index = next_index;
-          dist_from_start += highest_cost;
-          path_indices.push_back(current_index);
-        }
+        ClosePoseCandidate neighbor = { neighbor_dist, offset_x, offset_y };
+        queue.push(neighbor);
       }
     }
 
-    adjusted_index = current_index;
+    if (best.dist < required_final_distance){
+      ROS_WARN("Could not find pose with required distance from obstacles within allowed distance from start, returning original pose");
+      return false;
+    }
+
+    if (best.dist < desired_final_distance){
+      ROS_WARN("Could not find pose with desired distance from obstacles within allowed distance from start");
+    }
 
+    getNeighborIndex(grid_map, start_index, best.offset_x, best.offset_y, adjusted_index);
 
     return true;
   }
 
-  bool shortCutPath(grid_map::GridMap& grid_map,
-                    const std::vector <grid_map::Index>& path_in,
-                    std::vector <grid_map::Index>& path_out,
-                    const std::string dist_trans_layer,
-                    const std::string expl_trans_layer)
+  // Like shortCutValid, on float layers and quantized fields
+  template <class Data>
+  bool shortCutClear(const grid_map::GridMap& grid_map,
+                     const Data& dist_data,
+                     const typename Data::Scalar required_dist,
+                     const grid_map::Index& start_point,
+                     const grid_map::Index& end_point)
+  {
+    return grid_map_transforms::isRayClear(dist_data, grid_map.getStartIndex(), start_point, end_point, required_dist);
+  }
+
+  /*
+   * Keeps the path cells from which the farthest later cell is visible.
+   * The farthest visible cell is found by galloping (offsets 2, 4, 8, ...)
+   * to the first blocked test and bisecting between the last clear and
+   * the blocked one. Each kept cell thus costs O(log k) line checks of at
+   * most k cells, k being the offset to the next kept cell, so a path of n
+   * cells takes O(n log n) cell visits instead of O(n^2). Every kept
+   * segment is checked clear. Where visibility is interrupted and resumes
+   * along the path, later cells than the first blocked one can be kept,
+   * which only removes waypoints.
+   */
+  template <class Data>
+  void shortCutPathIndices(const grid_map::GridMap& grid_map,
+                           const Data& dist_data,
+                           const typename Data::Scalar required_dist,
+                           const std::vector <grid_map::Index>& path_in,
+                           std::vector <grid_map::Index>& path_out)
   {
     if (path_in.size() < 2){
       path_out = path_in;
-      return true;
+      return;
     }
 
-    grid_map::Matrix& dist_data = grid_map[dist_trans_layer];
-    grid_map::Matrix& expl_data = grid_map[expl_trans_layer];
+    const size_t last_idx = path_in.size() - 1;
 
     path_out.reserve(path_in.size());
     path_out.push_back(path_in[0]);
 
     size_t idx = 0;
 
-    while (idx < path_in.size()-2){
-      //std::cout << "idx: " << idx << " size: " << path_in.size() <<  "\n";
+    while (idx < last_idx - 1){
       const grid_map::Index& current_index (path_in[idx]);
 
-      //if (idx >= path_in.size()-30)
-      //  break;
-      //if ((idx + 2) > (path_in.size() -10))
-      //  break;
+      // Adjacent path cells are always connected
+      size_t clear_idx = idx + 1;
+      size_t blocked_idx = last_idx + 1;
 
-      for (size_t test_idx = idx + 2; test_idx < path_in.size(); ++test_idx){
-        const grid_map::Index& test_index = path_in[test_idx];
+      for (size_t offset = 2; clear_idx < last_idx; offset *= 2){
+        size_t test_idx = std::min(idx + offset, last_idx);
 
-        //std::cout << "idx: " << idx << " test_idx: " << test_idx << " size: " << path_in.size() << " \n";
-        if (!shortCutValid(grid_map, dist_data, current_index, test_index)){
-          idx = test_idx-1;
+        if (!shortCutClear(grid_map, dist_data, required_dist, current_index, path_in[test_idx])){
+          blocked_idx = test_idx;
           break;
-        }else{
-          if (test_idx == (path_in.size()-1)){
-            idx = test_idx;
-            break;
-          }
         }
+
+        clear_idx = test_idx;
       }
 
-      //std::cout << "size: " << path_in.size() << " idx: " << idx << "\n";
+      while (blocked_idx - clear_idx > 1){
+        size_t test_idx = clear_idx + (blocked_idx - clear_idx) / 2;
 
+        if (shortCutClear(grid_map, dist_data, required_dist, current_index, path_in[test_idx])){
+          clear_idx = test_idx;
+        }else{
+          blocked_idx = test_idx;
+        }
+      }
+
+      idx = clear_idx;
       path_out.push_back(path_in[idx]);
     }
 
-    if (idx < path_in.size()){
+    if (idx < last_idx){
       path_out.push_back(path_in.back());
     }
+  }
+
+  bool shortCutPath(const grid_map::GridMap& grid_map,
+                    const std::vector <grid_map::Index>& path_in,
+                    std::vector <grid_map::Index>& path_out,
+                    const std::string dist_trans_layer,
+                    const std::string expl_trans_layer,
+                    const float clearance)
+  {
+    shortCutPathIndices(grid_map, grid_map[dist_trans_layer], clearance, path_in, path_out);
+
+    return true;
+  }
+
+  bool shortCutPath(const grid_map::GridMap& grid_map,
+                    const grid_map_transforms::QuantizedField& dist_field,
+                    const std::vector <grid_map::Index>& path_in,
+                    std::vector <grid_map::Index>& path_out,
+                    const float clearance)
+  {
+    // clearance in field units, rounded up to the next quantized value
+    uint16_t required_dist = static_cast<uint16_t>(std::min(std::ceil(clearance / dist_field.scale),
+                                                            static_cast<float>(grid_map_transforms::QUANTIZED_MAX_VALUE)));
+
+    shortCutPathIndices(grid_map, dist_field.data, required_dist, path_in, path_out);
 
     return true;
   }
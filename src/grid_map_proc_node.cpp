@@ -0,0 +1,15 @@
+#include <grid_map_proc/grid_map_processor.h>
+
+int main(int argc, char** argv)
+{
+  ros::init(argc, argv, "grid_map_proc_node");
+
+  ros::NodeHandle nh;
+  ros::NodeHandle pnh("~");
+
+  grid_map_proc::GridMapProcessor processor (nh, pnh);
+
+  ros::spin();
+
+  return 0;
+}
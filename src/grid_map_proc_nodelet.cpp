@@ -0,0 +1,25 @@
+#include <grid_map_proc/grid_map_processor.h>
+
+#include <nodelet/nodelet.h>
+#include <pluginlib/class_list_macros.h>
+
+namespace grid_map_proc{
+
+  /*
+   * GridMapProcessor in a nodelet manager, in-process users can share the
+   * processed maps without serialization.
+   */
+  class GridMapProcNodelet : public nodelet::Nodelet
+  {
+  protected:
+    virtual void onInit()
+    {
+      processor_.reset(new GridMapProcessor(getNodeHandle(), getPrivateNodeHandle()));
+    }
+
+    std::unique_ptr<GridMapProcessor> processor_;
+  };
+
+} /* namespace */
+
+PLUGINLIB_EXPORT_CLASS(grid_map_proc::GridMapProcNodelet, nodelet::Nodelet)
@@ -0,0 +1,298 @@
+#include <grid_map_proc/grid_map_processor.h>
+#include <grid_map_proc/grid_map_path_planning.h>
+
+#include <nav_msgs/Path.h>
+
+#include <algorithm>
+
+namespace grid_map_proc{
+
+  GridMapProcessor::GridMapProcessor(ros::NodeHandle& nh,
+                                     ros::NodeHandle& pnh)
+    : num_dropped_inputs_(0)
+    , shutdown_(false)
+    , back_map_(new grid_map::GridMap())
+  {
+    double lethal_dist, penalty_dist, inflation_radius, path_step_length, transform_timeout;
+
+    pnh.param("occupancy_layer", occupancy_layer_, std::string("occupancy"));
+    pnh.param("robot_frame", robot_frame_, std::string("base_link"));
+    // In map cells, like the transforms
+    pnh.param("lethal_dist", lethal_dist, 6.0);
+    pnh.param("penalty_dist", penalty_dist, 12.0);
+    pnh.param("inflation_radius", inflation_radius, 0.0);
+    pnh.param("path_step_length", path_step_length, 5.0);
+    // exploration_transform (cell by cell descent) or interpolated
+    pnh.param("planner", planner_, std::string("exploration_transform"));
+    // Seconds to wait for the robot pose before an input is retried
+    pnh.param("transform_timeout", transform_timeout, 1.0);
+
+    lethal_dist_ = lethal_dist;
+    penalty_dist_ = penalty_dist;
+    inflation_radius_ = inflation_radius;
+    path_step_length_ = path_step_length;
+    transform_timeout_ = transform_timeout;
+
+    if ((planner_ != "exploration_transform") && (planner_ != "interpolated")){
+      ROS_WARN("Unknown planner %s, using exploration_transform", planner_.c_str());
+      planner_ = "exploration_transform";
+    }
+
+    grid_map_pub_ = nh.advertise<grid_map_msgs::GridMap>("grid_map_out", 1, true);
+    path_pub_ = nh.advertise<nav_msgs::Path>("path", 1);
+
+    worker_ = std::thread(&GridMapProcessor::processLoop, this);
+
+    // Callbacks only fill the input slot, so queues of one suffice
+    grid_map_sub_ = nh.subscribe("grid_map", 1, &GridMapProcessor::gridMapCallback, this);
+    occupancy_grid_sub_ = nh.subscribe("map", 1, &GridMapProcessor::occupancyGridCallback, this);
+    start_pose_sub_ = nh.subscribe("start_pose", 1, &GridMapProcessor::startPoseCallback, this);
+  }
+
+  GridMapProcessor::~GridMapProcessor()
+  {
+    grid_map_sub_.shutdown();
+    occupancy_grid_sub_.shutdown();
+    start_pose_sub_.shutdown();
+
+    {
+      std::lock_guard<std::mutex> lock (input_mutex_);
+      shutdown_ = true;
+    }
+
+    input_condition_.notify_one();
+
+    if (worker_.joinable())
+      worker_.join();
+  }
+
+  std::shared_ptr<const grid_map::GridMap> GridMapProcessor::getLatestMap() const
+  {
+    std::lock_guard<std::mutex> lock (buffer_mutex_);
+    return front_map_;
+  }
+
+  size_t GridMapProcessor::getNumDroppedInputs() const
+  {
+    std::lock_guard<std::mutex> lock (input_mutex_);
+    return num_dropped_inputs_;
+  }
+
+  void GridMapProcessor::gridMapCallback(const grid_map_msgs::GridMapConstPtr& msg)
+  {
+    {
+      std::lock_guard<std::mutex> lock (input_mutex_);
+
+      if (pending_grid_map_ || pending_occupancy_grid_)
+        ++num_dropped_inputs_;
+
+      pending_grid_map_ = msg;
+      pending_occupancy_grid_.reset();
+    }
+
+    input_condition_.notify_one();
+  }
+
+  void GridMapProcessor::occupancyGridCallback(const nav_msgs::OccupancyGridConstPtr& msg)
+  {
+    {
+      std::lock_guard<std::mutex> lock (input_mutex_);
+
+      if (pending_grid_map_ || pending_occupancy_grid_)
+        ++num_dropped_inputs_;
+
+      pending_occupancy_grid_ = msg;
+      pending_grid_map_.reset();
+    }
+
+    input_condition_.notify_one();
+  }
+
+  void GridMapProcessor::startPoseCallback(const geometry_msgs::PoseStampedConstPtr& msg)
+  {
+    // Runs on the front map while the worker fills the back map
+    std::shared_ptr<const grid_map::GridMap> grid_map (getLatestMap());
+
+    if (!grid_map){
+      ROS_WARN_THROTTLE(5.0, "No processed map yet, cannot plan");
+      return;
+    }
+
+    if (!msg->header.frame_id.empty() && (msg->header.frame_id != grid_map->getFrameId())){
+      ROS_WARN_THROTTLE(5.0, "Start pose frame %s differs from map frame %s", msg->header.frame_id.c_str(), grid_map->getFrameId().c_str());
+      return;
+    }
+
+    nav_msgs::Path path;
+
+    if (planner_ == "interpolated"){
+      if (!grid_map_path_planning::findPathExplorationTransformInterpolated(*grid_map, msg->pose, path.poses, path_step_length_))
+        return;
+    }else{
+      if (!grid_map_path_planning::findPathExplorationTransform(*grid_map, msg->pose, path.poses, 0, occupancy_layer_))
+        return;
+    }
+
+    path.header.frame_id = grid_map->getFrameId();
+    path.header.stamp = ros::Time::now();
+
+    for (size_t i = 0; i < path.poses.size(); ++i){
+      path.poses[i].header = path.header;
+    }
+
+    path_pub_.publish(path);
+  }
+
+  void GridMapProcessor::processLoop()
+  {
+    while (true){
+      grid_map_msgs::GridMapConstPtr grid_map_msg;
+      nav_msgs::OccupancyGridConstPtr occupancy_grid_msg;
+
+      {
+        std::unique_lock<std::mutex> lock (input_mutex_);
+
+        while (!shutdown_ && !pending_grid_map_ && !pending_occupancy_grid_){
+          input_condition_.wait(lock);
+        }
+
+        if (shutdown_)
+          return;
+
+        grid_map_msg.swap(pending_grid_map_);
+        occupancy_grid_msg.swap(pending_occupancy_grid_);
+      }
+
+      // Reachability is seeded at the robot. Without its pose the input is
+      // kept for a retry, a latched map would not be sent again.
+      const std::string& map_frame (grid_map_msg ? grid_map_msg->info.header.frame_id : occupancy_grid_msg->header.frame_id);
+      grid_map::Position robot_position;
+
+      if (!lookupRobotPosition(map_frame, robot_position)){
+        std::lock_guard<std::mutex> lock (input_mutex_);
+
+        if (!pending_grid_map_ && !pending_occupancy_grid_){
+          pending_grid_map_ = grid_map_msg;
+          pending_occupancy_grid_ = occupancy_grid_msg;
+        }
+
+        continue;
+      }
+
+      grid_map::GridMap& grid_map (*back_map_);
+
+      bool converted = grid_map_msg ?
+        grid_map::GridMapRosConverter::fromMessage(*grid_map_msg, grid_map) :
+        grid_map::GridMapRosConverter::fromOccupancyGrid(*occupancy_grid_msg, occupancy_layer_, grid_map);
+
+      if (!converted){
+        ROS_WARN("Could not convert input map");
+        continue;
+      }
+
+      // A reused buffer still has the layers of an earlier input
+      const std::vector<std::string> input_layers (grid_map_msg ? grid_map_msg->layers : std::vector<std::string>(1, occupancy_layer_));
+      const std::vector<std::string> layers (grid_map.getLayers());
+
+      for (size_t i = 0; i < layers.size(); ++i){
+        if ((std::find(input_layers.begin(), input_layers.end(), layers[i]) == input_layers.end()) &&
+            (layers[i] != "distance_transform") &&
+            (layers[i] != "exploration_transform") &&
+            (layers[i] != "occupancy_inflated")){
+          grid_map.erase(layers[i]);
+        }
+      }
+
+      if (!processMap(grid_map, robot_position))
+        continue;
+
+      swapBuffers();
+
+      if (grid_map_pub_.getNumSubscribers() > 0){
+        grid_map_msgs::GridMap msg;
+        grid_map::GridMapRosConverter::toMessage(*getLatestMap(), msg);
+        grid_map_pub_.publish(msg);
+      }
+    }
+  }
+
+  bool GridMapProcessor::lookupRobotPosition(const std::string& map_frame,
+                                             grid_map::Position& robot_position)
+  {
+    std::string error;
+
+    // Waits a while for the first transforms, e.g. a latched map arriving at startup
+    if (!tf_listener_.waitForTransform(map_frame, robot_frame_, ros::Time(0), ros::Duration(transform_timeout_), ros::Duration(0.01), &error)){
+      ROS_WARN_THROTTLE(5.0, "Cannot locate robot in map, retrying: %s", error.c_str());
+      return false;
+    }
+
+    tf::StampedTransform robot_transform;
+
+    try{
+      tf_listener_.lookupTransform(map_frame, robot_frame_, ros::Time(0), robot_transform);
+    }catch (tf::TransformException& e){
+      ROS_WARN_THROTTLE(5.0, "Cannot locate robot in map, retrying: %s", e.what());
+      return false;
+    }
+
+    robot_position = grid_map::Position(robot_transform.getOrigin().x(), robot_transform.getOrigin().y());
+    return true;
+  }
+
+  bool GridMapProcessor::processMap(grid_map::GridMap& grid_map,
+                                    const grid_map::Position& robot_position)
+  {
+    if (!grid_map.exists(occupancy_layer_)){
+      ROS_WARN_THROTTLE(5.0, "Input map has no layer %s", occupancy_layer_.c_str());
+      return false;
+    }
+
+    grid_map::Index seed_point;
+
+    if (!grid_map.getIndex(robot_position, seed_point)){
+      ROS_WARN_THROTTLE(5.0, "Robot is outside of the map");
+      return false;
+    }
+
+    std::vector<grid_map::Index> obstacle_cells;
+    std::vector<grid_map::Index> frontier_cells;
+
+    // Frontier cells are the goals
+    if (!grid_map_transforms::computeTransforms(grid_map,
+                                                seed_point,
+                                                std::vector<grid_map::Index>(),
+                                                obstacle_cells,
+                                                frontier_cells,
+                                                grid_map_transforms::DISTANCE_TRANSFORM_LAYER | grid_map_transforms::EXPLORATION_TRANSFORM_LAYER,
+                                                lethal_dist_,
+                                                penalty_dist_,
+                                                occupancy_layer_,
+                                                "distance_transform",
+                                                "exploration_transform",
+                                                &workspace_)){
+      return false;
+    }
+
+    // Output only, the transforms above use the plain occupancy layer
+    if ((inflation_radius_ > 0.0f) &&
+        !grid_map_transforms::addInflatedLayerFromDistance(grid_map, inflation_radius_, occupancy_layer_)){
+      ROS_WARN_THROTTLE(5.0, "Could not add inflated layer");
+    }
+
+    return true;
+  }
+
+  void GridMapProcessor::swapBuffers()
+  {
+    std::lock_guard<std::mutex> lock (buffer_mutex_);
+
+    front_map_.swap(back_map_);
+
+    // Readers only get maps through front_map_, so if nobody holds the old
+    // front map it can be reused, otherwise it stays with the reader
+    if (!back_map_ || (back_map_.use_count() > 1))
+      back_map_.reset(new grid_map::GridMap());
+  }
+
+} /* namespace */
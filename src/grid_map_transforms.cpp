@@ -1,10 +1,108 @@
 #include <grid_map_proc/grid_map_transforms.h>
+#include <grid_map_proc/grid_map_transform_policies.h>
+#include <grid_map_proc/grid_map_cv_bridge.h>
 
+#include "grid_map_transforms_internal.h"
+#include "grid_map_worker_pool.h"
 
 #include <opencv2/highgui/highgui.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <stdint.h>
+
 namespace grid_map_transforms{
 
+  // Definitions of the in-class constants, for uses that bind references
+  const int TiledLayout::TILE_BITS;
+  const int TiledLayout::TILE_SIZE;
+  const int TiledLayout::TILE_MASK;
+  const int TiledLayout::TILE_CELLS;
+
+  /*
+   * Fallback of the transforms that do not handle circular buffers: they
+   * run on a copy of their input layers in default start index order (as
+   * GridMap::convertToDefaultStartIndex would leave them, other layers are
+   * not copied) and their output layers are copied back in buffer order.
+   */
+
+  // rotated(x, y) = data((x + shift_x) % size_x, (y + shift_y) % size_y)
+  void rotateLayer(const grid_map::Matrix& data,
+                   const grid_map::Index& shift,
+                   grid_map::Matrix& rotated)
+  {
+    const int size_x = data.rows();
+    const int size_y = data.cols();
+    const int shift_x = shift(0);
+    const int shift_y = shift(1);
+
+    rotated.resize(size_x, size_y);
+
+    rotated.topLeftCorner(size_x - shift_x, size_y - shift_y) = data.bottomRightCorner(size_x - shift_x, size_y - shift_y);
+    rotated.topRightCorner(size_x - shift_x, shift_y) = data.bottomLeftCorner(size_x - shift_x, shift_y);
+    rotated.bottomLeftCorner(shift_x, size_y - shift_y) = data.topRightCorner(shift_x, size_y - shift_y);
+    rotated.bottomRightCorner(shift_x, shift_y) = data.topLeftCorner(shift_x, shift_y);
+  }
+
+  grid_map::GridMap unwrappedCopy(const grid_map::GridMap& grid_map,
+                                  const std::vector<std::string>& layers)
+  {
+    grid_map::GridMap unwrapped;
+    unwrapped.setFrameId(grid_map.getFrameId());
+    unwrapped.setTimestamp(grid_map.getTimestamp());
+    unwrapped.setGeometry(grid_map.getLength(), grid_map.getResolution(), grid_map.getPosition());
+
+    grid_map::Matrix data;
+
+    for (size_t i = 0; i < layers.size(); ++i){
+      if (!grid_map.exists(layers[i]))
+        continue;
+
+      rotateLayer(grid_map[layers[i]], grid_map.getStartIndex(), data);
+      unwrapped.add(layers[i], data);
+    }
+
+    return unwrapped;
+  }
+
+  void copyLayerWrapped(const grid_map::GridMap& unwrapped,
+                        const std::string& layer,
+                        grid_map::GridMap& grid_map)
+  {
+    const grid_map::Size& size (grid_map.getSize());
+    const grid_map::Index& start_index (grid_map.getStartIndex());
+
+    rotateLayer(unwrapped[layer],
+                grid_map::Index((size(0) - start_index(0)) % size(0), (size(1) - start_index(1)) % size(1)),
+                grid_map_cv_bridge::getOrAddLayer(grid_map, layer));
+  }
+
+  grid_map::Index unwrapIndex(const grid_map::GridMap& grid_map,
+                              const grid_map::Index& index)
+  {
+    return grid_map::getIndexFromBufferIndex(index, grid_map.getSize(), grid_map.getStartIndex());
+  }
+
+  std::vector<grid_map::Index> unwrapIndices(const grid_map::GridMap& grid_map,
+                                             const std::vector<grid_map::Index>& indices)
+  {
+    std::vector<grid_map::Index> unwrapped (indices.size());
+
+    for (size_t i = 0; i < indices.size(); ++i){
+      unwrapped[i] = unwrapIndex(grid_map, indices[i]);
+    }
+
+    return unwrapped;
+  }
+
+  void wrapIndices(const grid_map::GridMap& grid_map,
+                   std::vector<grid_map::Index>& indices)
+  {
+    for (size_t i = 0; i < indices.size(); ++i){
+      indices[i] = grid_map::getBufferIndexFromIndex(indices[i], grid_map.getSize(), grid_map.getStartIndex());
+    }
+  }
+
   bool addInflatedLayer(grid_map::GridMap& grid_map,
                                      const float inflation_radius_map_cells,
                                      const std::string occupancy_layer,
@@ -13,23 +111,21 @@ namespace grid_map_transforms{
     if (!grid_map.exists(occupancy_layer))
       return false;
 
-    grid_map::Matrix& grid_data = grid_map[occupancy_layer];
-
-    cv::Mat map_mat = cv::Mat(grid_map.getSize()(0), grid_map.getSize()(1), CV_8UC1);
+    if (!isDefaultStartIndex(grid_map)){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer}));
 
-    uchar *input = (uchar*)(map_mat.data);
+      if (!addInflatedLayer(unwrapped, inflation_radius_map_cells, occupancy_layer, inflated_occupancy_layer))
+        return false;
 
-    size_t size_x = grid_map.getSize()(0);
-    size_t size_y = grid_map.getSize()(1);
-
-    for (size_t idx_x = 0; idx_x < size_x; ++idx_x){
-      for (size_t idx_y = 0; idx_y < size_y; ++idx_y){
-        input[map_mat.cols * idx_x + idx_y] = (grid_data(idx_x, idx_y)) == 100.0 ? 255 : 0 ;
-      }
+      copyLayerWrapped(unwrapped, inflated_occupancy_layer, grid_map);
+      return true;
     }
 
-    grid_map.add(inflated_occupancy_layer);
-    grid_map::Matrix& data_inflated (grid_map[inflated_occupancy_layer]);
+    const grid_map::Matrix& grid_data = grid_map[occupancy_layer];
+
+    // All cv::Mat below are transposed views/masks of the column-major layers
+    cv::Mat inflated_mat;
+    grid_map_cv_bridge::getComparisonMask(grid_data, 100.0, cv::CMP_EQ, inflated_mat);
 
     int erosion_type = cv::MORPH_ELLIPSE;
     int erosion_size = inflation_radius_map_cells;
@@ -37,34 +133,60 @@ namespace grid_map_transforms{
                                                  cv::Size( 2*erosion_size + 1, 2*erosion_size+1 ),
                                                  cv::Point( erosion_size, erosion_size ) );
 
-    cv::Mat inflated_mat = cv::Mat(grid_map.getSize()(0), grid_map.getSize()(1), CV_8UC1);
-    uchar *inflated_map_p = (uchar*)(inflated_mat.data);
-
-    cv::dilate(map_mat, inflated_mat, element);
+    // The discretized ellipse is not symmetric, transpose it like the data
+    cv::dilate(inflated_mat, inflated_mat, element.t());
 
-    for (size_t idx_x = 0; idx_x < size_x; ++idx_x){
-      for (size_t idx_y = 0; idx_y < size_y; ++idx_y){
+    // Only free space gets marked occupied, everything else is copied
+    cv::Mat free_mat;
+    grid_map_cv_bridge::getComparisonMask(grid_data, 0.0, cv::CMP_EQ, free_mat);
+    cv::bitwise_and(inflated_mat, free_mat, inflated_mat);
 
-        if (grid_data (idx_x, idx_y) != 0.0){
-          // If not free space, copy old map
-          data_inflated(idx_x, idx_y) = grid_data(idx_x, idx_y);
-        }else{
+    grid_map::Matrix& data_inflated (grid_map_cv_bridge::getOrAddLayer(grid_map, inflated_occupancy_layer));
+    data_inflated = grid_map[occupancy_layer];
 
-          if (inflated_map_p[map_mat.cols * idx_x + idx_y] != 0){
-            // If free space and inflated in dilated map, mark occupied
-            data_inflated(idx_x, idx_y) = 100.0;
-          }else{
-            // Otherwise copy old map
-            data_inflated(idx_x, idx_y) = grid_data (idx_x, idx_y);
-          }
-        }
-      }
-    }
+    cv::Mat data_inflated_view (grid_map_cv_bridge::getTransposedView(data_inflated));
+    data_inflated_view.setTo(100.0, inflated_mat);
 
     return true;
   }
   
   
+  bool addInflatedLayerFromDistance(grid_map::GridMap& grid_map,
+                                    const float inflation_radius_map_cells,
+                                    const std::string occupancy_layer,
+                                    const std::string inflated_occupancy_layer,
+                                    const int num_threads)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    const grid_map::Matrix& grid_data = grid_map[occupancy_layer];
+
+    // Squared euclidean distances of all obstacles, compared squared
+    grid_map::Matrix dist_data = (grid_data.array() == 100.0).select(grid_map::Matrix::Zero(grid_data.rows(), grid_data.cols()),
+                                                                     std::numeric_limits<float>::max());
+    squaredEuclideanDistanceTransform(dist_data, num_threads, grid_map.getStartIndex());
+
+    const float threshold = inflation_radius_map_cells * inflation_radius_map_cells;
+
+    grid_map::Matrix& data_inflated (grid_map_cv_bridge::getOrAddLayer(grid_map, inflated_occupancy_layer));
+
+    const float* occupancy = grid_data.data();
+    const float* dist = dist_data.data();
+    float* inflated = data_inflated.data();
+
+    // Branch free compare and select so the compiler can vectorize it. Free
+    // cells within the radius become occupied, everything else is copied.
+    const size_t size = grid_data.size();
+
+    for (size_t i = 0; i < size; ++i){
+      bool inflate = (occupancy[i] == 0.0f) & (dist[i] <= threshold);
+      inflated[i] = inflate ? 100.0f : occupancy[i];
+    }
+
+    return true;
+  }
+
   bool addDistanceTransformCv(grid_map::GridMap& grid_map,
                               const std::string occupancy_layer,
                               const std::string dist_trans_layer)
@@ -72,423 +194,2554 @@ namespace grid_map_transforms{
     if (!grid_map.exists(occupancy_layer))
       return false;
 
-    grid_map::Matrix& grid_data = grid_map[occupancy_layer];
+    if (!isDefaultStartIndex(grid_map)){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer}));
 
-    cv::Mat map_mat = cv::Mat(grid_map.getSize()(0), grid_map.getSize()(1), CV_8UC1);
-    
-    
-    float lowerValue = 100.0;
-    float upperValue = 0.0;
-    
-    uchar *input = (uchar*)(map_mat.data);
-    
-    float inv_up_subtr_low = 1.0 / (upperValue - lowerValue);
-    
-    //grid_map::Index index;
-    size_t size_x = grid_map.getSize()(0);
-    size_t size_y = grid_map.getSize()(1);
+      if (!addDistanceTransformCv(unwrapped, occupancy_layer, dist_trans_layer))
+        return false;
 
-    for (size_t idx_x = 0; idx_x < size_x; ++idx_x){
-      for (size_t idx_y = 0; idx_y < size_y; ++idx_y){
-        //input[map_mat.cols * idx_x + idx_y] = (uchar) (((grid_data(idx_x, idx_y) - lowerValue) * inv_up_subtr_low) * (float) 255);
-        input[map_mat.cols * idx_x + idx_y] = (grid_data(idx_x, idx_y)) == 100.0 ? 0 : 255 ;
-      }
+      copyLayerWrapped(unwrapped, dist_trans_layer, grid_map);
+      return true;
     }
 
+    // Everything that is not occupied is foreground for the distance transform
+    cv::Mat map_mat;
+    grid_map_cv_bridge::getComparisonMask(grid_map[occupancy_layer], 100.0, cv::CMP_NE, map_mat);
+
     //cv::namedWindow("converted_map");
     //cv::imshow("converted_map", map_mat);
     //cv::waitKey();
 
-    grid_map.add(dist_trans_layer);
-    grid_map::Matrix& data_normal (grid_map[dist_trans_layer]);
-    
-    //Have to work around row vs column major representation in cv vs eigen
-    Eigen::Matrix<float, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor> data (data_normal);
-    
-    cv::Mat distance_transformed (data.rows(), data.cols(), CV_32FC1, data.data());
+    grid_map::Matrix& data (grid_map_cv_bridge::getOrAddLayer(grid_map, dist_trans_layer));
+
+    // Transposed view of the layer, the chamfer mask is symmetric so the
+    // result can be written in place without reordering
+    cv::Mat distance_transformed (grid_map_cv_bridge::getTransposedView(data));
     
     // @TODO Appears OpenCV 2.4 broken in that it does not provide required enums. Looked up and manually added values
     // https://github.com/opencv/opencv/blob/master/modules/imgproc/include/opencv2/imgproc.hpp#L308
     cv::distanceTransform(map_mat, distance_transformed, 2, 3);
-    
-    data_normal = data;
 
     return true;
   }
 
+  void buildOccupancyCodes(const grid_map::Matrix& occupancy,
+                           OccupancyCodes& occupancy_codes,
+                           const int border_width,
+                           const grid_map::Index& start_index)
+  {
+    occupancy_codes.resize(occupancy.rows(), occupancy.cols());
+
+    const float* occupancy_data = occupancy.data();
+    unsigned char* codes = occupancy_codes.data();
+
+    const size_t size = occupancy.size();
+
+    // NaN compares unequal to both, so it ends up unknown
+    for (size_t i = 0; i < size; ++i){
+      float val = occupancy_data[i];
+      codes[i] = (val == 0.0f) ? FREE_CELL : ((val == 100.0f) ? OCCUPIED_CELL : UNKNOWN_CELL);
+    }
+
+    const int size_x = occupancy_codes.rows();
+    const int size_y = occupancy_codes.cols();
+
+    // Sentinel rings, cells on them receive values but are never expanded.
+    // The map edge is at the buffer start index.
+    for (int ring = 0; ring < border_width; ++ring){
+      int low_y = (std::min(ring, size_y-1) + start_index(1)) % size_y;
+      int high_y = (std::max(size_y-1-ring, 0) + start_index(1)) % size_y;
+
+      for (int idx_x = 0; idx_x < size_x; ++idx_x){
+        occupancy_codes(idx_x, low_y) |= BORDER_CELL;
+        occupancy_codes(idx_x, high_y) |= BORDER_CELL;
+      }
+
+      int low_x = (std::min(ring, size_x-1) + start_index(0)) % size_x;
+      int high_x = (std::max(size_x-1-ring, 0) + start_index(0)) % size_x;
+
+      for (int idx_y = 0; idx_y < size_y; ++idx_y){
+        occupancy_codes(low_x, idx_y) |= BORDER_CELL;
+        occupancy_codes(high_x, idx_y) |= BORDER_CELL;
+      }
+    }
+
+    if ((start_index == 0).all())
+      return;
+
+    // Expanded cells on the buffer edge need wrapped neighbors
+    for (int idx_y = 0; idx_y < size_y; ++idx_y){
+      bool edge_column = (idx_y < border_width) || (idx_y >= size_y - border_width);
+
+      for (int idx_x = 0; idx_x < size_x; ++idx_x){
+        if (!edge_column && (idx_x == border_width) && (idx_x < size_x - border_width))
+          idx_x = size_x - border_width;
+
+        unsigned char& code = occupancy_codes(idx_x, idx_y);
+
+        if (!(code & BORDER_CELL))
+          code |= WRAPPED_CELL;
+      }
+    }
+  }
+
+  void updateOccupancyCodes(const grid_map::Matrix& occupancy,
+                            const std::vector<grid_map::Index>& changed_cells,
+                            OccupancyCodes& occupancy_codes)
+  {
+    for (size_t i = 0; i < changed_cells.size(); ++i){
+      const grid_map::Index& point = changed_cells[i];
+      float val = occupancy(point(0), point(1));
+      unsigned char& code = occupancy_codes(point(0), point(1));
+      code = (code & ~OCCUPANCY_CODE_MASK) | ((val == 0.0f) ? FREE_CELL : ((val == 100.0f) ? OCCUPIED_CELL : UNKNOWN_CELL));
+    }
+  }
+
+  // Existing layers are overwritten in place, add() allocates a new matrix
+  grid_map::Matrix& resetLayer(grid_map::GridMap& grid_map,
+                               const std::string& layer,
+                               const float value)
+  {
+    grid_map::Matrix& data (grid_map_cv_bridge::getOrAddLayer(grid_map, layer));
+    data.setConstant(value);
+    return data;
+  }
+
+  void propagateDistance(const OccupancyCodes& occupancy_codes,
+                         grid_map::Matrix& expl_layer,
+                         CellQueue& point_queue,
+                         std::vector<grid_map::Index>* changed_cells = 0)
+  {
+    const int size_x = expl_layer.rows();
+
+    const NeighborOffsets neighbors (size_x, expl_layer.cols());
+
+    const unsigned char* codes = occupancy_codes.data();
+    float* dist_data = expl_layer.data();
+
+    int wrapped_offsets[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      float current_val = dist_data[index];
+
+      // Raised by updateDistanceTransform after it was queued
+      if (current_val == std::numeric_limits<float>::max())
+        continue;
+
+      const int* offsets = neighbors.offsetsAt(codes[index], index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        int neighbor = index + offsets[i];
+
+        if (touchDistCell(codes,
+                          dist_data,
+                          neighbor,
+                          current_val,
+                          neighbors.costs[i],
+                          point_queue) && changed_cells){
+          changed_cells->push_back(grid_map::Index(neighbor % size_x, neighbor / size_x));
+        }
+      }
+    }
+  }
+
+  void searchReachableObstacleCells(const OccupancyCodes& occupancy_codes,
+                                    grid_map::Matrix& expl_layer,
+                                    const grid_map::Index& seed_point,
+                                    std::vector<grid_map::Index>& obstacle_cells,
+                                    std::vector<grid_map::Index>& frontier_cells,
+                                    CellQueue& point_queue)
+  {
+    const NeighborOffsets neighbors (expl_layer.rows(), expl_layer.cols());
+
+    float* seed_data = expl_layer.data();
+
+    point_queue.reset(expl_layer.size());
+
+    expl_layer(seed_point(0), seed_point(1)) = 0.0;
+
+    pushSeedCells(occupancy_codes, std::vector<grid_map::Index>(1, seed_point), point_queue);
+
+    int wrapped_offsets[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      const int* offsets = neighbors.offsetsAt(occupancy_codes.data()[index], index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        touchObstacleSearchCell(occupancy_codes,
+                                seed_data,
+                                index,
+                                index + offsets[i],
+                                obstacle_cells,
+                                frontier_cells,
+                                point_queue);
+      }
+    }
+  }
+
   bool addDistanceTransform(grid_map::GridMap& grid_map,
                             const grid_map::Index& seed_point,
                             std::vector<grid_map::Index>& obstacle_cells,
                             std::vector<grid_map::Index>& frontier_cells,
                             const std::string occupancy_layer,
-                            const std::string dist_trans_layer)
+                            const std::string dist_trans_layer,
+                            TransformWorkspace* workspace)
   {
     if (!grid_map.exists(occupancy_layer))
       return false;
 
-    grid_map::Matrix& grid_data = grid_map[occupancy_layer];
+    TransformWorkspace local_workspace;
 
-    grid_map.add(dist_trans_layer, std::numeric_limits<float>::max());
-    grid_map::Matrix& expl_layer (grid_map[dist_trans_layer]);
+    if (!workspace)
+      workspace = &local_workspace;
 
-    std::queue<grid_map::Index> point_queue;
+    // Shared by the reachability search and the propagation
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
 
     obstacle_cells.clear();
     frontier_cells.clear();
 
+    CellQueue point_queue (workspace->queue_buffer);
+
+    searchReachableObstacleCells(occupancy_codes,
+                                 resetLayer(grid_map, "dist_seed_transform", std::numeric_limits<float>::max()),
+                                 seed_point,
+                                 obstacle_cells,
+                                 frontier_cells,
+                                 point_queue);
 
-    collectReachableObstacleCells(grid_map,
-                                  seed_point,
-                                  obstacle_cells,
-                                  frontier_cells);
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, dist_trans_layer, std::numeric_limits<float>::max()));
+
+    point_queue.reset(expl_layer.size());
 
     for (size_t i = 0; i < obstacle_cells.size(); ++i){
       const grid_map::Index& point = obstacle_cells[i];
       expl_layer(point(0), point(1)) = 0.0;
-      point_queue.push(point);
     }
 
-    size_t size_x_lim = grid_map.getSize()(0) -1;
-    size_t size_y_lim = grid_map.getSize()(1) -1;
-
-    float adjacent_dist = 0.955;
-    float diagonal_dist = 1.3693;
+    pushSeedCells(occupancy_codes, obstacle_cells, point_queue);
 
-    while (point_queue.size()){
-      grid_map::Index point (point_queue.front());
-      point_queue.pop();
+    propagateDistance(occupancy_codes, expl_layer, point_queue);
 
-      //Reject points near border here early as to not require checks later
-      if (point(0) < 1 || point(0) >= size_x_lim ||
-          point(1) < 1 || point(1) >= size_y_lim){
-          continue;
-      }
+    return true;
 
-      float current_val = expl_layer(point(0), point(1));
+  }
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1)-1,
-                      current_val,
-                      diagonal_dist,
-                      point_queue);
+  // Squared 1D distance transform of sampled function f (lower envelope of
+  // parabolas, Felzenszwalb & Huttenlocher). Entries >= inf are not sampled.
+  void squaredDistanceTransform1d(const float* f,
+                                  float* d,
+                                  const int n,
+                                  const float inf,
+                                  int* v,
+                                  double* z)
+  {
+    int k = -1;
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0),
-                      point(1)-1,
-                      current_val,
-                      adjacent_dist,
-                      point_queue);
+    for (int q = 0; q < n; ++q){
+      if (f[q] >= inf)
+        continue;
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1)-1,
-                      current_val,
-                      diagonal_dist,
-                      point_queue);
+      double s = 0.0;
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1),
-                      current_val,
-                      adjacent_dist,
-                      point_queue);
+      while (k >= 0){
+        s = ((f[q] + static_cast<double>(q) * q) - (f[v[k]] + static_cast<double>(v[k]) * v[k])) / (2.0 * (q - v[k]));
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1),
-                      current_val,
-                      adjacent_dist,
-                      point_queue);
+        if (s > z[k])
+          break;
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1)+1,
-                      current_val,
-                      diagonal_dist,
-                      point_queue);
+        --k;
+      }
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0),
-                      point(1)+1,
-                      current_val,
-                      adjacent_dist,
-                      point_queue);
+      ++k;
+      v[k] = q;
+      z[k] = (k == 0) ? -std::numeric_limits<double>::max() : s;
+      z[k+1] = std::numeric_limits<double>::max();
+    }
 
-      touchDistCell(grid_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1)+1,
-                      current_val,
-                      diagonal_dist,
-                      point_queue);
+    if (k < 0){
+      std::fill(d, d + n, inf);
+      return;
     }
 
-    return true;
+    k = 0;
+
+    for (int q = 0; q < n; ++q){
+      while (z[k+1] < q){
+        ++k;
+      }
 
+      double dq = q - v[k];
+      d[q] = dq * dq + f[v[k]];
+    }
   }
 
-  bool addExplorationTransform(grid_map::GridMap& grid_map,
-                            const std::vector<grid_map::Index>& goal_points,
-                            const float lethal_dist,
-                            const float penalty_dist,
-                            const std::string occupancy_layer,
-                            const std::string dist_trans_layer,
-                            const std::string expl_trans_layer)
+  void squaredEuclideanDistanceTransform(grid_map::Matrix& data,
+                                         const int num_threads,
+                                         const grid_map::Index& start_index)
   {
-    if (!grid_map.exists(occupancy_layer))
-      return false;
+    const float max_val = std::numeric_limits<float>::max();
 
-    if (!grid_map.exists(dist_trans_layer))
-      return false;
+    const int size_x = data.rows();
+    const int size_y = data.cols();
 
-    const grid_map::Matrix& grid_data (grid_map[occupancy_layer]);
-    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+    // Both passes run along unwrapped lines, which start at the buffer start index
+    const int start_x = start_index(0);
+    const int start_y = start_index(1);
 
-    grid_map.add(expl_trans_layer, std::numeric_limits<float>::max());
-    grid_map::Matrix& expl_layer (grid_map[expl_trans_layer]);
+    // Column pass, storage is contiguous along x
+    parallelFor(0, size_y, num_threads, [&](int begin, int end){
+      std::vector<float> f (size_x);
+      std::vector<float> d (size_x);
+      std::vector<int> v (size_x);
+      std::vector<double> z (size_x + 1);
 
-    std::queue<grid_map::Index> point_queue;
+      for (int idx_y = begin; idx_y < end; ++idx_y){
+        float* column = &data(0, idx_y);
 
-    for (size_t i = 0; i < goal_points.size(); ++i){
-      const grid_map::Index& point = goal_points[i];
-      expl_layer(point(0), point(1)) = 0.0;
-      point_queue.push(point);
-    }
+        if (start_x == 0){
+          squaredDistanceTransform1d(column, &d[0], size_x, max_val, &v[0], &z[0]);
+          std::copy(d.begin(), d.end(), column);
+        }else{
+          std::rotate_copy(column, column + start_x, column + size_x, f.begin());
+          squaredDistanceTransform1d(&f[0], &d[0], size_x, max_val, &v[0], &z[0]);
+          std::rotate_copy(d.begin(), d.end() - start_x, d.end(), column);
+        }
+      }
+    });
 
-    size_t size_x_lim = grid_map.getSize()(0) -1;
-    size_t size_y_lim = grid_map.getSize()(1) -1;
+    // Row pass, gathered into a contiguous buffer
+    parallelFor(0, size_x, num_threads, [&](int begin, int end){
+      std::vector<float> f (size_y);
+      std::vector<float> d (size_y);
+      std::vector<int> v (size_y);
+      std::vector<double> z (size_y + 1);
 
-    float adjacent_dist = 0.955;
-    float diagonal_dist = 1.3693;
+      for (int idx_x = begin; idx_x < end; ++idx_x){
+        for (int idx_y = 0, buffer_y = start_y; idx_y < size_y; ++idx_y, ++buffer_y){
+          if (buffer_y == size_y)
+            buffer_y = 0;
 
-    //std::cout << "pq size:" << point_queue.size() << "\n";
+          f[idx_y] = data(idx_x, buffer_y);
+        }
 
-    while (point_queue.size()){
-      grid_map::Index point (point_queue.front());
-      point_queue.pop();
+        squaredDistanceTransform1d(&f[0], &d[0], size_y, max_val, &v[0], &z[0]);
 
-      //Reject points near border here early as to not require checks later
-      if (point(0) < 1 || point(0) >= size_x_lim ||
-          point(1) < 1 || point(1) >= size_y_lim){
-          continue;
-      }
+        for (int idx_y = 0, buffer_y = start_y; idx_y < size_y; ++idx_y, ++buffer_y){
+          if (buffer_y == size_y)
+            buffer_y = 0;
 
-      float current_val = expl_layer(point(0), point(1));
+          data(idx_x, buffer_y) = d[idx_y];
+        }
+      }
+    });
+  }
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1)-1,
-                      current_val,
-                      diagonal_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+  /*
+   * Linear buffer index of the cell offset_x, offset_y away from point.
+   * Works on circular buffers, returns false if the cell is outside the map.
+   */
+  inline bool getNeighborIndex(const grid_map::Index& point,
+                               const int offset_x,
+                               const int offset_y,
+                               const grid_map::Size& size,
+                               const grid_map::Index& start_index,
+                               int& neighbor)
+  {
+    grid_map::Index unwrapped (grid_map::getIndexFromBufferIndex(point, size, start_index));
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0),
-                      point(1)-1,
-                      current_val,
-                      adjacent_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    unwrapped += grid_map::Index(offset_x, offset_y);
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1)-1,
-                      current_val,
-                      diagonal_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    if (!grid_map::checkIfIndexInRange(unwrapped, size))
+      return false;
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1),
-                      current_val,
-                      adjacent_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    grid_map::Index buffer_index (grid_map::getBufferIndexFromIndex(unwrapped, size, start_index));
+    neighbor = buffer_index(0) + buffer_index(1) * size(0);
+    return true;
+  }
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1),
-                      current_val,
-                      adjacent_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+  // True if the map edge of occupancy_codes is at start_index, i.e. they
+  // were built for the current position of the circular buffer
+  bool hasBorderAt(const OccupancyCodes& occupancy_codes,
+                   const grid_map::Index& start_index)
+  {
+    const int size_x = occupancy_codes.rows();
+    const int size_y = occupancy_codes.cols();
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)-1,
-                      point(1)+1,
-                      current_val,
-                      diagonal_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    const int low_x = start_index(0);
+    const int high_x = (start_index(0) + size_x - 1) % size_x;
+    const int low_y = start_index(1);
+    const int high_y = (start_index(1) + size_y - 1) % size_y;
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0),
-                      point(1)+1,
-                      current_val,
-                      adjacent_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    for (int idx_y = 0; idx_y < size_y; ++idx_y){
+      if (!(occupancy_codes(low_x, idx_y) & BORDER_CELL) || !(occupancy_codes(high_x, idx_y) & BORDER_CELL))
+        return false;
+    }
 
-      touchExplorationCell(grid_data,
-                      dist_data,
-                      expl_layer,
-                      point(0)+1,
-                      point(1)+1,
-                      current_val,
-                      diagonal_dist,
-                      lethal_dist,
-                      penalty_dist,
-                      point_queue);
+    for (int idx_x = 0; idx_x < size_x; ++idx_x){
+      if (!(occupancy_codes(idx_x, low_y) & BORDER_CELL) || !(occupancy_codes(idx_x, high_y) & BORDER_CELL))
+        return false;
     }
 
     return true;
   }
 
-
-  bool collectReachableObstacleCells(grid_map::GridMap& grid_map,
-                                     const grid_map::Index& seed_point,
-                                     std::vector<grid_map::Index>& obstacle_cells,
-                                     std::vector<grid_map::Index>& frontier_cells,
-                                     const std::string occupancy_layer,
-                                     const std::string dist_seed_layer)
+  bool updateDistanceTransform(grid_map::GridMap& grid_map,
+                               const std::vector<grid_map::Index>& changed_cells,
+                               OccupancyCodes& occupancy_codes,
+                               const std::string occupancy_layer,
+                               const std::string dist_trans_layer,
+                               std::vector<grid_map::Index>* changed_dist_cells)
   {
-
     if (!grid_map.exists(occupancy_layer))
       return false;
 
-    grid_map::Matrix& grid_data = grid_map[occupancy_layer];
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    const grid_map::Size& size (grid_map.getSize());
+    const grid_map::Index& start_index (grid_map.getStartIndex());
 
-    std::queue<grid_map::Index> point_queue;
-    point_queue.push(seed_point);
+    // Only the first update (or one after a resize or move) builds all codes
+    if ((occupancy_codes.rows() != size(0)) || (occupancy_codes.cols() != size(1)) ||
+        !hasBorderAt(occupancy_codes, start_index)){
+      buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, start_index);
+    }else{
+      updateOccupancyCodes(grid_map[occupancy_layer], changed_cells, occupancy_codes);
+    }
 
-    grid_map.add(dist_seed_layer, std::numeric_limits<float>::max());
-    grid_map::Matrix& expl_layer (grid_map[dist_seed_layer]);
+    const OccupancyCodes& codes (occupancy_codes);
+    grid_map::Matrix& dist_layer (grid_map[dist_trans_layer]);
 
-    expl_layer(seed_point(0), seed_point(1)) = 0.0;
+    const int size_x = size(0);
+    const int size_y = size(1);
 
-    size_t size_x_lim = grid_map.getSize()(0) -1;
-    size_t size_y_lim = grid_map.getSize()(1) -1;
+    const NeighborOffsets neighbors (size_x, size_y);
 
-    float adjacent_dist = 0.955;
-    float diagonal_dist = 1.3693;
+    const unsigned char* code_data = codes.data();
+    float* dist_data = dist_layer.data();
 
-    while (point_queue.size()){
+    const float max_val = std::numeric_limits<float>::max();
 
-      grid_map::Index point (point_queue.front());
-      point_queue.pop();
+    // Raised cells with the value they held before
+    std::queue<std::pair<int, float> > raise_queue;
 
-      //Reject points near border here early as to not require checks later
-      if (point(0) < 1 || point(0) >= size_x_lim ||
-          point(1) < 1 || point(1) >= size_y_lim){
+    // Valid cells at the boundary of the raised region. Sized for the
+    // wavefront, not the map, the queue grows as needed.
+    CellQueue lower_queue;
+    lower_queue.reset(changed_cells.size() * 8);
+
+    // Classify changes. Previous state of a cell can be inferred from the
+    // distance layer: 0 for seeded obstacles, finite for reached free cells.
+    for (size_t i = 0; i < changed_cells.size(); ++i){
+      const grid_map::Index& point = changed_cells[i];
+      const int index = point(0) + point(1) * size_x;
+
+      float old_val = dist_data[index];
+      unsigned char code = code_data[index] & OCCUPANCY_CODE_MASK;
+
+      // Occupied
+      if (code == OCCUPIED_CELL){
+        if (old_val == 0.0f){
           continue;
-      }
+        }
+
+        bool reached = old_val != max_val;
+
+        for (int i = 0; (i < 8) && !reached; ++i){
+          int neighbor;
+
+          if (!getNeighborIndex(point, neighbors.dx[i], neighbors.dy[i], size, start_index, neighbor))
+            continue;
+
+          // Like the full transform, only expanded (non border) cells find
+          // obstacles. Wrapped cells are expanded as well.
+          if (((code_data[neighbor] & ~WRAPPED_CELL) == FREE_CELL) && (dist_data[neighbor] != max_val))
+            reached = true;
+        }
+
+        // Only seed obstacles bordering the region reached previously
+        if (reached){
+          dist_data[index] = 0.0;
+
+          if (!(code_data[index] & BORDER_CELL))
+            lower_queue.push(index);
 
-      float current_val = expl_layer(point(0), point(1));
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)-1,
-                           point(1)-1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0),
-                           point(1)-1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)+1,
-                           point(1)-1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)-1,
-                           point(1),
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)+1,
-                           point(1),
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)-1,
-                           point(1)+1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0),
-                           point(1)+1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
-
-      touchObstacleSearchCell(grid_data,
-                           expl_layer,
-                           point,
-                           point(0)+1,
-                           point(1)+1,
-                           obstacle_cells,
-                           frontier_cells,
-                           point_queue);
+          if (changed_dist_cells){
+            changed_dist_cells->push_back(point);
+          }
+        }
+
+      // Free
+      }else if (code == FREE_CELL){
+        if (old_val == 0.0f){
+          // Former obstacle, everything derived from it has to be raised
+          dist_data[index] = max_val;
+          raise_queue.push(std::make_pair(index, old_val));
+
+        }else if (old_val == max_val){
+          // Formerly unknown or unreached, lower from valid neighbors
+          for (int i = 0; i < 8; ++i){
+            int neighbor;
+
+            if (!getNeighborIndex(point, neighbors.dx[i], neighbors.dy[i], size, start_index, neighbor))
+              continue;
+
+            if ((dist_data[neighbor] != max_val) && !(code_data[neighbor] & BORDER_CELL)){
+              lower_queue.push(neighbor);
+            }
+          }
+        }
+
+      // Unknown
+      }else{
+        if (old_val != max_val){
+          dist_data[index] = max_val;
+          raise_queue.push(std::make_pair(index, old_val));
+        }
+      }
     }
 
+    int wrapped_offsets[8];
+
+    // Raise: Invalidate all cells that might have been derived from raised
+    // cells, collect the remaining valid cells at the boundary for lowering.
+    while (raise_queue.size()){
+      const int index = raise_queue.front().first;
+      const float raised_val = raise_queue.front().second;
+      raise_queue.pop();
+
+      if (changed_dist_cells){
+        changed_dist_cells->push_back(grid_map::Index(index % size_x, index / size_x));
+      }
+
+      const unsigned char code = code_data[index];
+
+      // Border cells never propagated, so nothing can depend on them. They
+      // are lowered again from their valid neighbors.
+      if (code & BORDER_CELL){
+        const grid_map::Index point (index % size_x, index / size_x);
+
+        for (int i = 0; i < 8; ++i){
+          int neighbor;
+
+          if (!getNeighborIndex(point, neighbors.dx[i], neighbors.dy[i], size, start_index, neighbor))
+            continue;
+
+          if ((dist_data[neighbor] != max_val) && !(code_data[neighbor] & BORDER_CELL))
+            lower_queue.push(neighbor);
+        }
+        continue;
+      }
+
+      const int* offsets = neighbors.offsetsAt(code, index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        touchDistRaiseCell(code_data,
+                           dist_data,
+                           index + offsets[i],
+                           raised_val,
+                           neighbors.costs[i],
+                           raise_queue,
+                           lower_queue);
+      }
+    }
+
+    // Lower: Regular propagation starting from the valid wavefront. Cells
+    // raised after having been queued hold max and are skipped.
+    propagateDistance(codes, dist_layer, lower_queue, changed_dist_cells);
+
+    return true;
+  }
+
+  bool collectChangedOccupancyCells(grid_map::GridMap& grid_map,
+                                    const std::string previous_occupancy_layer,
+                                    std::vector<grid_map::Index>& changed_cells,
+                                    const std::string occupancy_layer)
+  {
+    changed_cells.clear();
+
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    const grid_map::Matrix& grid_data (grid_map[occupancy_layer]);
+
+    if (!grid_map.exists(previous_occupancy_layer)){
+      grid_map.add(previous_occupancy_layer, grid_data);
+      return false;
+    }
+
+    grid_map::Matrix& previous_data (grid_map[previous_occupancy_layer]);
+
+    size_t size_x = grid_map.getSize()(0);
+    size_t size_y = grid_map.getSize()(1);
+
+    for (size_t idx_y = 0; idx_y < size_y; ++idx_y){
+      for (size_t idx_x = 0; idx_x < size_x; ++idx_x){
+        float val = grid_data(idx_x, idx_y);
+        float previous_val = previous_data(idx_x, idx_y);
+
+        // Unknown cells are usually NaN, which never compares equal
+        if ((val != previous_val) && !(std::isnan(val) && std::isnan(previous_val))){
+          changed_cells.push_back(grid_map::Index(idx_x, idx_y));
+          previous_data(idx_x, idx_y) = val;
+        }
+      }
+    }
+
+    return true;
+  }
+
+  bool addDistanceTransformEdt(grid_map::GridMap& grid_map,
+                               const grid_map::Index& seed_point,
+                               std::vector<grid_map::Index>& obstacle_cells,
+                               std::vector<grid_map::Index>& frontier_cells,
+                               const int num_threads,
+                               const std::string occupancy_layer,
+                               const std::string dist_trans_layer,
+                               TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    obstacle_cells.clear();
+    frontier_cells.clear();
+
+    CellQueue point_queue (workspace->queue_buffer);
+
+    searchReachableObstacleCells(occupancy_codes,
+                                 resetLayer(grid_map, "dist_seed_transform", std::numeric_limits<float>::max()),
+                                 seed_point,
+                                 obstacle_cells,
+                                 frontier_cells,
+                                 point_queue);
+
+    const float max_val = std::numeric_limits<float>::max();
+
+    // The layer holds squared distances until the final pass
+    grid_map::Matrix& dist_layer (resetLayer(grid_map, dist_trans_layer, max_val));
+
+    for (size_t i = 0; i < obstacle_cells.size(); ++i){
+      const grid_map::Index& point = obstacle_cells[i];
+      dist_layer(point(0), point(1)) = 0.0;
+    }
+
+    squaredEuclideanDistanceTransform(dist_layer, num_threads, grid_map.getStartIndex());
+
+    // Only free cells receive a distance, like in addDistanceTransform
+    parallelFor(0, dist_layer.cols(), num_threads, [&](int begin, int end){
+      for (int idx_y = begin; idx_y < end; ++idx_y){
+        for (int idx_x = 0; idx_x < dist_layer.rows(); ++idx_x){
+          float& dist = dist_layer(idx_x, idx_y);
+
+          // Seeded obstacles stay at 0
+          if (dist == 0.0f){
+            continue;
+          }
+
+          if (((occupancy_codes(idx_x, idx_y) & OCCUPANCY_CODE_MASK) != FREE_CELL) || (dist >= max_val)){
+            dist = max_val;
+          }else{
+            dist = std::sqrt(dist);
+          }
+        }
+      }
+    });
+
+    return true;
+  }
+
+  bool addExplorationTransform(grid_map::GridMap& grid_map,
+                            const std::vector<grid_map::Index>& goal_points,
+                            const float lethal_dist,
+                            const float penalty_dist,
+                            const std::string occupancy_layer,
+                            const std::string dist_trans_layer,
+                            const std::string expl_trans_layer,
+                            ExplorationTransformStats* stats,
+                            TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, expl_trans_layer, std::numeric_limits<float>::max()));
+
+    CellQueue point_queue (workspace->queue_buffer);
+    point_queue.reset(expl_layer.size());
+
+    size_t num_pushed = 0;
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      const grid_map::Index& point = goal_points[i];
+      expl_layer(point(0), point(1)) = 0.0;
+    }
+
+    pushSeedCells(occupancy_codes, goal_points, point_queue);
+
+    const NeighborOffsets neighbors (expl_layer.rows(), expl_layer.cols());
+
+    const unsigned char* codes = occupancy_codes.data();
+    const float* dist = dist_data.data();
+    float* expl = expl_layer.data();
+
+    int wrapped_offsets[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      ++num_pushed;
+
+      float current_val = expl[index];
+
+      const int* offsets = neighbors.offsetsAt(codes[index], index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        touchExplorationCell(codes,
+                             dist,
+                             expl,
+                             index + offsets[i],
+                             current_val,
+                             neighbors.costs[i],
+                             lethal_dist,
+                             penalty_dist,
+                             point_queue);
+      }
+    }
+
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = (expl_layer.array() != std::numeric_limits<float>::max()).count();
+    }
+
+    return true;
+  }
+
+  void propagateExplorationBucketed(const OccupancyCodes& occupancy_codes,
+                                    const grid_map::Matrix& dist_data,
+                                    Eigen::Ref<grid_map::Matrix> expl_layer,
+                                    const std::vector<grid_map::Index>& goal_points,
+                                    const float lethal_dist,
+                                    const float penalty_dist,
+                                    ExplorationTransformStats* stats,
+                                    std::vector<std::vector<int> >& buckets,
+                                    std::vector<unsigned char>& settled)
+  {
+    propagateExploration<Neighborhood<8> >(occupancy_codes,
+                                           LethalPenaltyCost(dist_data, lethal_dist, penalty_dist),
+                                           expl_layer,
+                                           goal_points,
+                                           stats,
+                                           buckets,
+                                           settled);
+  }
+
+  bool addExplorationTransformBucketed(grid_map::GridMap& grid_map,
+                                       const std::vector<grid_map::Index>& goal_points,
+                                       const float lethal_dist,
+                                       const float penalty_dist,
+                                       const std::string occupancy_layer,
+                                       const std::string dist_trans_layer,
+                                       const std::string expl_trans_layer,
+                                       ExplorationTransformStats* stats,
+                                       TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, expl_trans_layer, std::numeric_limits<float>::max()));
+
+    propagateExplorationBucketed(occupancy_codes,
+                                 dist_data,
+                                 expl_layer,
+                                 goal_points,
+                                 lethal_dist,
+                                 penalty_dist,
+                                 stats,
+                                 workspace->buckets,
+                                 workspace->cell_state);
+
+    return true;
+  }
+
+  void touchReachabilityCellTiled(const TiledLayout& layout,
+                                  const unsigned char* occupancy_codes,
+                                  std::vector<unsigned char>& cell_state,
+                                  const int current_index,
+                                  const int index,
+                                  std::vector<grid_map::Index>& obstacle_cells,
+                                  std::vector<grid_map::Index>& frontier_cells,
+                                  CellQueue& point_queue)
+  {
+    const unsigned char code = occupancy_codes[index];
+    unsigned char& state = cell_state[index];
+
+    // Free
+    if ((code & OCCUPANCY_CODE_MASK) == FREE_CELL){
+      if (!(state & REACHABLE_CELL)){
+        state |= REACHABLE_CELL;
+
+        if (!(code & BORDER_CELL))
+          point_queue.push(index);
+      }
+    // Occupied
+    }else if ((code & OCCUPANCY_CODE_MASK) == OCCUPIED_CELL){
+      if (!(state & OBSTACLE_CELL)){
+        state |= OBSTACLE_CELL;
+        obstacle_cells.push_back(layout.cell(index));
+      }
+    // Unknown
+    }else{
+      unsigned char& current_state = cell_state[current_index];
+
+      if (!(current_state & FRONTIER_CELL)){
+        current_state |= FRONTIER_CELL;
+        frontier_cells.push_back(layout.cell(current_index));
+      }
+    }
+  }
+
+  // Tiled occupancy codes, padding cells are unknown border cells that are never reached
+  void buildTiledOccupancyCodes(const grid_map::Matrix& occupancy,
+                                const TiledLayout& layout,
+                                TransformWorkspace& workspace)
+  {
+    buildOccupancyCodes(occupancy, workspace.occupancy_codes);
+
+    layout.toTiled(workspace.occupancy_codes,
+                   workspace.tiled_codes,
+                   static_cast<unsigned char>(UNKNOWN_CELL | BORDER_CELL));
+  }
+
+  bool addDistanceTransformTiled(grid_map::GridMap& grid_map,
+                                 const grid_map::Index& seed_point,
+                                 std::vector<grid_map::Index>& obstacle_cells,
+                                 std::vector<grid_map::Index>& frontier_cells,
+                                 const std::string occupancy_layer,
+                                 const std::string dist_trans_layer,
+                                 TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!isDefaultStartIndex(grid_map)){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer}));
+
+      if (!addDistanceTransformTiled(unwrapped, unwrapIndex(grid_map, seed_point), obstacle_cells, frontier_cells,
+                                     occupancy_layer, dist_trans_layer, workspace))
+        return false;
+
+      wrapIndices(grid_map, obstacle_cells);
+      wrapIndices(grid_map, frontier_cells);
+      copyLayerWrapped(unwrapped, dist_trans_layer, grid_map);
+      return true;
+    }
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    const TiledLayout layout (grid_map.getSize()(0), grid_map.getSize()(1));
+
+    buildTiledOccupancyCodes(grid_map[occupancy_layer], layout, *workspace);
+
+    const unsigned char* codes = &workspace->tiled_codes[0];
+
+    obstacle_cells.clear();
+    frontier_cells.clear();
+
+    // Reachability in the workspace, no dist_seed_transform layer is added
+    std::vector<unsigned char>& cell_state (workspace->cell_state);
+    cell_state.assign(layout.size(), 0);
+
+    CellQueue point_queue (workspace->queue_buffer);
+    point_queue.reset(layout.size());
+
+    int seed_index = layout.index(seed_point(0), seed_point(1));
+    cell_state[seed_index] = REACHABLE_CELL;
+
+    if (!(codes[seed_index] & BORDER_CELL))
+      point_queue.push(seed_index);
+
+    int neighbor_indices[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      layout.neighbors(index, neighbor_indices);
+
+      for (int i = 0; i < 8; ++i){
+        touchReachabilityCellTiled(layout,
+                                   codes,
+                                   cell_state,
+                                   index,
+                                   neighbor_indices[i],
+                                   obstacle_cells,
+                                   frontier_cells,
+                                   point_queue);
+      }
+    }
+
+    std::vector<float>& tiled_dist (workspace->tiled_dist);
+    tiled_dist.assign(layout.size(), std::numeric_limits<float>::max());
+
+    float* dist_data = &tiled_dist[0];
+
+    point_queue.reset(layout.size());
+
+    for (size_t i = 0; i < obstacle_cells.size(); ++i){
+      int index = layout.index(obstacle_cells[i](0), obstacle_cells[i](1));
+      dist_data[index] = 0.0;
+
+      if (!(codes[index] & BORDER_CELL))
+        point_queue.push(index);
+    }
+
+    const NeighborOffsets neighbors (grid_map.getSize()(0));
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      float current_val = dist_data[index];
+
+      layout.neighbors(index, neighbor_indices);
+
+      for (int i = 0; i < 8; ++i){
+        touchDistCell(codes,
+                      dist_data,
+                      neighbor_indices[i],
+                      current_val,
+                      neighbors.costs[i],
+                      point_queue);
+      }
+    }
+
+    layout.fromTiled(tiled_dist, grid_map_cv_bridge::getOrAddLayer(grid_map, dist_trans_layer));
+
+    return true;
+  }
+
+  bool addExplorationTransformTiled(grid_map::GridMap& grid_map,
+                                    const std::vector<grid_map::Index>& goal_points,
+                                    const float lethal_dist,
+                                    const float penalty_dist,
+                                    const std::string occupancy_layer,
+                                    const std::string dist_trans_layer,
+                                    const std::string expl_trans_layer,
+                                    ExplorationTransformStats* stats,
+                                    TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!isDefaultStartIndex(grid_map)){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer, dist_trans_layer}));
+
+      if (!addExplorationTransformTiled(unwrapped, unwrapIndices(grid_map, goal_points), lethal_dist, penalty_dist,
+                                        occupancy_layer, dist_trans_layer, expl_trans_layer, stats, workspace))
+        return false;
+
+      copyLayerWrapped(unwrapped, expl_trans_layer, grid_map);
+      return true;
+    }
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    const TiledLayout layout (grid_map.getSize()(0), grid_map.getSize()(1));
+
+    buildTiledOccupancyCodes(grid_map[occupancy_layer], layout, *workspace);
+
+    layout.toTiled(grid_map[dist_trans_layer], workspace->tiled_dist, std::numeric_limits<float>::max());
+
+    std::vector<float>& tiled_expl (workspace->tiled_expl);
+    tiled_expl.assign(layout.size(), std::numeric_limits<float>::max());
+
+    const LethalPenaltyCost cost_policy (&workspace->tiled_dist[0], lethal_dist, penalty_dist);
+    const NeighborOffsets neighbors (grid_map.getSize()(0));
+
+    // Same bucket queue as propagateExploration
+    float bucket_width = 0.955f;
+    float max_step_cost = *std::max_element(neighbors.costs, neighbors.costs + 8) + cost_policy.maxCellCost();
+
+    size_t num_buckets = static_cast<size_t>(std::ceil(max_step_cost / bucket_width)) + 2;
+
+    std::vector<std::vector<int> >& buckets (workspace->buckets);
+    buckets.resize(num_buckets);
+
+    for (size_t i = 0; i < num_buckets; ++i){
+      buckets[i].clear();
+    }
+
+    std::vector<unsigned char>& settled (workspace->cell_state);
+    settled.assign(layout.size(), 0);
+
+    const unsigned char* codes = &workspace->tiled_codes[0];
+    float* expl = &tiled_expl[0];
+
+    size_t num_pushed = 0;
+    size_t num_settled = 0;
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      int index = layout.index(goal_points[i](0), goal_points[i](1));
+      expl[index] = 0.0;
+
+      if (!(codes[index] & BORDER_CELL)){
+        buckets[0].push_back(index);
+        ++num_pushed;
+      }
+    }
+
+    size_t num_queued = num_pushed;
+
+    int neighbor_indices[8];
+
+    for (size_t bucket = 0; num_queued > 0; ++bucket){
+      std::vector<int>& current_bucket = buckets[bucket % num_buckets];
+
+      while (!current_bucket.empty()){
+        int index = current_bucket.back();
+        current_bucket.pop_back();
+        --num_queued;
+
+        if (settled[index])
+          continue;
+
+        settled[index] = 1;
+        ++num_settled;
+
+        float current_val = expl[index];
+
+        size_t pushed_before = num_pushed;
+
+        layout.neighbors(index, neighbor_indices);
+
+        for (int i = 0; i < 8; ++i){
+          touchExplorationCellBucketed(codes,
+                                       cost_policy,
+                                       expl,
+                                       neighbor_indices[i],
+                                       current_val,
+                                       neighbors.costs[i],
+                                       bucket_width,
+                                       buckets,
+                                       num_pushed);
+        }
+
+        num_queued += num_pushed - pushed_before;
+      }
+    }
+
+    layout.fromTiled(tiled_expl, grid_map_cv_bridge::getOrAddLayer(grid_map, expl_trans_layer));
+
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = num_settled;
+    }
+
+    return true;
+  }
+
+  /*
+   * One bucketed propagation per goal set into the given fields, which must
+   * be initialized to max. Goal sets are split across num_threads, the
+   * first thread uses the workspace buffers.
+   */
+  void propagateExplorationBatch(const OccupancyCodes& occupancy_codes,
+                                 const grid_map::Matrix& dist_data,
+                                 const std::vector<float*>& expl_fields,
+                                 const std::vector<std::vector<grid_map::Index> >& goal_sets,
+                                 const float lethal_dist,
+                                 const float penalty_dist,
+                                 const int num_threads,
+                                 ExplorationTransformStats* stats,
+                                 TransformWorkspace& workspace)
+  {
+    const int num_fields = goal_sets.size();
+
+    std::vector<ExplorationTransformStats> field_stats (num_fields);
+
+    parallelFor(0, num_fields, num_threads, [&](int begin, int end){
+      std::vector<std::vector<int> > thread_buckets;
+      std::vector<unsigned char> thread_settled;
+
+      std::vector<std::vector<int> >& buckets ((begin == 0) ? workspace.buckets : thread_buckets);
+      std::vector<unsigned char>& settled ((begin == 0) ? workspace.cell_state : thread_settled);
+
+      for (int k = begin; k < end; ++k){
+        Eigen::Map<grid_map::Matrix> expl_layer (expl_fields[k], dist_data.rows(), dist_data.cols());
+
+        propagateExplorationBucketed(occupancy_codes,
+                                     dist_data,
+                                     expl_layer,
+                                     goal_sets[k],
+                                     lethal_dist,
+                                     penalty_dist,
+                                     &field_stats[k],
+                                     buckets,
+                                     settled);
+      }
+    });
+
+    if (stats){
+      *stats = ExplorationTransformStats();
+
+      for (int k = 0; k < num_fields; ++k){
+        stats->pushed_cells += field_stats[k].pushed_cells;
+        stats->settled_cells += field_stats[k].settled_cells;
+      }
+    }
+  }
+
+  bool computeExplorationTransformBatch(const grid_map::GridMap& grid_map,
+                                        const std::vector<std::vector<grid_map::Index> >& goal_sets,
+                                        std::vector<float>& expl_fields,
+                                        const float lethal_dist,
+                                        const float penalty_dist,
+                                        const int num_threads,
+                                        const std::string occupancy_layer,
+                                        const std::string dist_trans_layer,
+                                        ExplorationTransformStats* stats,
+                                        TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    const size_t num_cells = dist_data.size();
+
+    expl_fields.assign(num_cells * goal_sets.size(), std::numeric_limits<float>::max());
+
+    std::vector<float*> field_data (goal_sets.size());
+
+    for (size_t k = 0; k < goal_sets.size(); ++k){
+      field_data[k] = &expl_fields[k * num_cells];
+    }
+
+    propagateExplorationBatch(occupancy_codes,
+                              dist_data,
+                              field_data,
+                              goal_sets,
+                              lethal_dist,
+                              penalty_dist,
+                              num_threads,
+                              stats,
+                              *workspace);
+
+    return true;
+  }
+
+  bool addExplorationTransformBatch(grid_map::GridMap& grid_map,
+                                    const std::vector<std::vector<grid_map::Index> >& goal_sets,
+                                    const std::vector<std::string>& expl_trans_layers,
+                                    const float lethal_dist,
+                                    const float penalty_dist,
+                                    const int num_threads,
+                                    const std::string occupancy_layer,
+                                    const std::string dist_trans_layer,
+                                    ExplorationTransformStats* stats,
+                                    TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    if (goal_sets.size() != expl_trans_layers.size())
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    // Layers are added before any thread starts, fields are written in place
+    std::vector<float*> field_data (goal_sets.size());
+
+    for (size_t k = 0; k < goal_sets.size(); ++k){
+      field_data[k] = resetLayer(grid_map, expl_trans_layers[k], std::numeric_limits<float>::max()).data();
+    }
+
+    propagateExplorationBatch(occupancy_codes,
+                              grid_map[dist_trans_layer],
+                              field_data,
+                              goal_sets,
+                              lethal_dist,
+                              penalty_dist,
+                              num_threads,
+                              stats,
+                              *workspace);
+
+    return true;
+  }
+
+  bool addExplorationTransformParallel(grid_map::GridMap& grid_map,
+                                       const std::vector<grid_map::Index>& goal_points,
+                                       const int num_threads,
+                                       const float lethal_dist,
+                                       const float penalty_dist,
+                                       const int tile_size,
+                                       const std::string occupancy_layer,
+                                       const std::string dist_trans_layer,
+                                       const std::string expl_trans_layer)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!isDefaultStartIndex(grid_map)){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer, dist_trans_layer}));
+
+      if (!addExplorationTransformParallel(unwrapped, unwrapIndices(grid_map, goal_points), num_threads, lethal_dist, penalty_dist,
+                                           tile_size, occupancy_layer, dist_trans_layer, expl_trans_layer))
+        return false;
+
+      copyLayerWrapped(unwrapped, expl_trans_layer, grid_map);
+      return true;
+    }
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    // Needed so concurrently processed tiles never write the same cell
+    if (tile_size < 2)
+      return false;
+
+    OccupancyCodes occupancy_codes;
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes);
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, expl_trans_layer, std::numeric_limits<float>::max()));
+
+    const int size_x = grid_map.getSize()(0);
+    const int size_y = grid_map.getSize()(1);
+
+    const int tiles_x = (size_x + tile_size - 1) / tile_size;
+    const int tiles_y = (size_y + tile_size - 1) / tile_size;
+
+    // Cells per tile whose value changed but that were not expanded yet
+    std::vector<std::vector<int> > tile_pending (tiles_x * tiles_y);
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      const grid_map::Index& point = goal_points[i];
+      expl_layer(point(0), point(1)) = 0.0;
+
+      int tile = point(0) / tile_size + (point(1) / tile_size) * tiles_x;
+      tile_pending[tile].push_back(point(0) + point(1) * size_x);
+    }
+
+    const float adjacent_dist = 0.955;
+    const float diagonal_dist = 1.3693;
+
+    const int offsets_x[8] = {-1,  0,  1, -1, 1, -1, 0, 1};
+    const int offsets_y[8] = {-1, -1, -1,  0, 0,  1, 1, 1};
+    const float step_costs[8] = {diagonal_dist, adjacent_dist, diagonal_dist, adjacent_dist,
+                                 adjacent_dist, diagonal_dist, adjacent_dist, diagonal_dist};
+
+    // Cells are only expanded up to the current threshold, which grows by
+    // roughly one tile of free space per round (delta stepping).
+    const float threshold_step = tile_size * adjacent_dist;
+    float threshold = threshold_step;
+
+    typedef std::pair<float, int> QueueEntry;
+
+    // Improvements of cells in neighboring tiles, merged after each phase
+    std::vector<std::vector<std::pair<int, int> > > thread_outboxes (std::max(1, num_threads));
+
+    auto process_tile = [&](int tile, std::vector<std::pair<int, int> >& outbox){
+      const int tile_x = tile % tiles_x;
+      const int tile_y = tile / tiles_x;
+
+      const int min_x = tile_x * tile_size;
+      const int min_y = tile_y * tile_size;
+      const int max_x = std::min(size_x, min_x + tile_size) -1;
+      const int max_y = std::min(size_y, min_y + tile_size) -1;
+
+      std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > point_queue;
+
+      std::vector<int>& pending = tile_pending[tile];
+
+      for (size_t i = 0; i < pending.size(); ++i){
+        point_queue.push(QueueEntry(expl_layer.data()[pending[i]], pending[i]));
+      }
+      pending.clear();
+
+      while (point_queue.size()){
+        QueueEntry entry (point_queue.top());
+
+        if (entry.first > threshold)
+          break;
+
+        point_queue.pop();
+
+        // Stale entry, cell has been improved since
+        if (entry.first != expl_layer.data()[entry.second])
+          continue;
+
+        int point_x = entry.second % size_x;
+        int point_y = entry.second / size_x;
+
+        //Reject points near border here early as to not require checks later
+        if (point_x < 1 || point_x >= size_x -1 ||
+            point_y < 1 || point_y >= size_y -1){
+            continue;
+        }
+
+        float current_val = entry.first;
+
+        for (int i = 0; i < 8; ++i){
+          int x = point_x + offsets_x[i];
+          int y = point_y + offsets_y[i];
+
+          //If not free at cell, skip
+          if ((occupancy_codes(x, y) & OCCUPANCY_CODE_MASK) != FREE_CELL)
+            continue;
+
+          float dist = dist_data(x, y);
+
+          if (dist < lethal_dist)
+            continue;
+
+          float cost = current_val + step_costs[i];
+
+          if (dist < penalty_dist){
+            float add_cost = (penalty_dist - dist);
+            cost += add_cost * add_cost;
+          }
+
+          if (expl_layer(x, y) > cost){
+            expl_layer(x, y) = cost;
+
+            if (x < min_x || x > max_x || y < min_y || y > max_y){
+              outbox.push_back(std::make_pair(x / tile_size + (y / tile_size) * tiles_x, x + y * size_x));
+            }else{
+              point_queue.push(QueueEntry(cost, x + y * size_x));
+            }
+          }
+        }
+      }
+
+      // Keep everything beyond the threshold for later rounds
+      while (point_queue.size()){
+        pending.push_back(point_queue.top().second);
+        point_queue.pop();
+      }
+    };
+
+    std::vector<int> color_tiles;
+
+    WorkerPool& worker_pool (WorkerPool::shared());
+
+    while (true){
+      bool any_pending = false;
+      bool any_processed = false;
+
+      // Tiles of one color in a 2x2 pattern never touch each other, not even
+      // diagonally, so they can be processed concurrently.
+      for (int color = 0; color < 4; ++color){
+        color_tiles.clear();
+
+        for (int tile_y = color / 2; tile_y < tiles_y; tile_y += 2){
+          for (int tile_x = color % 2; tile_x < tiles_x; tile_x += 2){
+            int tile = tile_x + tile_y * tiles_x;
+            const std::vector<int>& pending = tile_pending[tile];
+
+            for (size_t i = 0; i < pending.size(); ++i){
+              if (expl_layer.data()[pending[i]] <= threshold){
+                color_tiles.push_back(tile);
+                break;
+              }
+            }
+          }
+        }
+
+        if (color_tiles.empty())
+          continue;
+
+        any_processed = true;
+
+        std::atomic<size_t> next_tile (0);
+
+        // Workers stay up between phases, run returns once all are done
+        worker_pool.run(std::min(thread_outboxes.size(), color_tiles.size()), [&](int thread){
+          size_t i;
+          while ((i = next_tile.fetch_add(1)) < color_tiles.size()){
+            process_tile(color_tiles[i], thread_outboxes[thread]);
+          }
+        });
+
+        for (size_t thread = 0; thread < thread_outboxes.size(); ++thread){
+          std::vector<std::pair<int, int> >& outbox = thread_outboxes[thread];
+
+          for (size_t i = 0; i < outbox.size(); ++i){
+            tile_pending[outbox[i].first].push_back(outbox[i].second);
+          }
+          outbox.clear();
+        }
+      }
+
+      if (any_processed)
+        continue;
+
+      for (size_t tile = 0; tile < tile_pending.size(); ++tile){
+        if (!tile_pending[tile].empty()){
+          any_pending = true;
+          break;
+        }
+      }
+
+      if (!any_pending)
+        break;
+
+      threshold += threshold_step;
+    }
+
+    return true;
+  }
+
+  bool addExplorationTransformToStart(grid_map::GridMap& grid_map,
+                                      const std::vector<grid_map::Index>& goal_points,
+                                      const grid_map::Index& start_index,
+                                      const float lethal_dist,
+                                      const float penalty_dist,
+                                      const bool use_heuristic,
+                                      const std::string occupancy_layer,
+                                      const std::string dist_trans_layer,
+                                      const std::string expl_trans_layer,
+                                      ExploredRegion* explored_region,
+                                      TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    // Out of range starts are rejected below
+    if (!isDefaultStartIndex(grid_map) && grid_map::checkIfIndexInRange(start_index, grid_map.getSize())){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer, dist_trans_layer}));
+
+      if (!addExplorationTransformToStart(unwrapped, unwrapIndices(grid_map, goal_points), unwrapIndex(grid_map, start_index),
+                                          lethal_dist, penalty_dist, use_heuristic, occupancy_layer, dist_trans_layer,
+                                          expl_trans_layer, explored_region, workspace))
+        return false;
+
+      copyLayerWrapped(unwrapped, expl_trans_layer, grid_map);
+      return true;
+    }
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    const int size_x = grid_map.getSize()(0);
+    const int size_y = grid_map.getSize()(1);
+
+    if (start_index(0) < 0 || start_index(0) >= size_x ||
+        start_index(1) < 0 || start_index(1) >= size_y){
+      return false;
+    }
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes);
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    const float max_val = std::numeric_limits<float>::max();
+
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, expl_trans_layer, max_val));
+
+    const float adjacent_dist = 0.955;
+    const float diagonal_dist = 1.3693;
+
+    // Slightly shrunk so float rounding of the sums can not make the
+    // heuristic inconsistent, which would settle cells too early
+    const float heuristic_scale = use_heuristic ? 0.99999f : 0.0f;
+
+    const int start_x = start_index(0);
+    const int start_y = start_index(1);
+    const int start = start_x + start_y * size_x;
+
+    const int offsets_x[8] = {-1,  0,  1, -1, 1, -1, 0, 1};
+    const int offsets_y[8] = {-1, -1, -1,  0, 0,  1, 1, 1};
+
+    const NeighborOffsets neighbors (size_x);
+
+    const unsigned char* codes = occupancy_codes.data();
+    const float* dist = dist_data.data();
+    float* expl = expl_layer.data();
+
+    typedef std::pair<float, int> QueueEntry;
+
+    // Binary min heap on the workspace storage
+    std::vector<QueueEntry>& queue (workspace->heap);
+    queue.clear();
+
+    std::vector<unsigned char>& closed (workspace->cell_state);
+    closed.assign(expl_layer.size(), 0);
+
+    ExploredRegion region;
+    region.min_index = grid_map::Index(size_x, size_y);
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      const grid_map::Index& point = goal_points[i];
+      int index = point(0) + point(1) * size_x;
+
+      if (expl[index] == max_val){
+        ++region.reached_cells;
+        region.min_index = region.min_index.min(point);
+        region.max_index = region.max_index.max(point);
+      }
+
+      expl[index] = 0.0;
+
+      int dx = std::abs(point(0) - start_x);
+      int dy = std::abs(point(1) - start_y);
+
+      float heuristic = heuristic_scale * (adjacent_dist * std::abs(dx - dy) + diagonal_dist * std::min(dx, dy));
+
+      queue.push_back(QueueEntry(heuristic, index));
+      std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+    }
+
+    while (!queue.empty()){
+      std::pop_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+      int index = queue.back().second;
+      queue.pop_back();
+
+      // Outdated entry of a cell that was settled with a lower value
+      if (closed[index])
+        continue;
+
+      closed[index] = 1;
+      ++region.expanded_cells;
+
+      if (index == start){
+        region.start_reached = true;
+        break;
+      }
+
+      if (codes[index] & BORDER_CELL)
+        continue;
+
+      const int point_x = index % size_x;
+      const int point_y = index / size_x;
+
+      const float current_val = expl[index];
+
+      for (int i = 0; i < 8; ++i){
+        int neighbor = index + neighbors.offsets[i];
+
+        //If not free at cell, skip
+        if ((codes[neighbor] & OCCUPANCY_CODE_MASK) != FREE_CELL)
+          continue;
+
+        float neighbor_dist = dist[neighbor];
+
+        if (neighbor_dist < lethal_dist)
+          continue;
+
+        float cost = current_val + neighbors.costs[i];
+
+        if (neighbor_dist < penalty_dist){
+          float add_cost = (penalty_dist - neighbor_dist);
+          cost += add_cost * add_cost;
+        }
+
+        float& neighbor_val = expl[neighbor];
+
+        if (neighbor_val > cost){
+          int x = point_x + offsets_x[i];
+          int y = point_y + offsets_y[i];
+
+          if (neighbor_val == max_val){
+            ++region.reached_cells;
+            region.min_index = region.min_index.min(grid_map::Index(x, y));
+            region.max_index = region.max_index.max(grid_map::Index(x, y));
+          }
+
+          neighbor_val = cost;
+
+          int dx = std::abs(x - start_x);
+          int dy = std::abs(y - start_y);
+
+          float heuristic = heuristic_scale * (adjacent_dist * std::abs(dx - dy) + diagonal_dist * std::min(dx, dy));
+
+          queue.push_back(QueueEntry(cost + heuristic, neighbor));
+          std::push_heap(queue.begin(), queue.end(), std::greater<QueueEntry>());
+        }
+      }
+    }
+
+    if (region.reached_cells == 0){
+      region.min_index = grid_map::Index(0, 0);
+    }
+
+    if (explored_region){
+      *explored_region = region;
+    }
+
+    return true;
+  }
+
+  /*
+   * Connected part of a block on the coarse level of the hierarchical
+   * exploration transform. Only the cells along the block edges are kept,
+   * one bit per cell: low_x/high_x by row, low_y/high_y by column.
+   */
+  struct CoarseNode
+  {
+    int block;
+    float largest_dist;
+    uint64_t low_x;
+    uint64_t high_x;
+    uint64_t low_y;
+    uint64_t high_y;
+  };
+
+  bool growComponentRow(uint64_t* component,
+                        uint64_t* free_rows,
+                        const int row,
+                        const int height)
+  {
+    uint64_t reach = component[row];
+
+    if (row > 0)
+      reach |= component[row - 1];
+
+    if (row < height - 1)
+      reach |= component[row + 1];
+
+    uint64_t added = ((reach << 1) | reach | (reach >> 1)) & free_rows[row];
+
+    if (!added)
+      return false;
+
+    // Whole runs of free cells are taken at once
+    while (added){
+      component[row] |= added;
+      free_rows[row] &= ~added;
+      added = ((added << 1) | (added >> 1)) & free_rows[row];
+    }
+
+    return true;
+  }
+
+  bool coarseNodesTouch(const CoarseNode& node,
+                        const CoarseNode& neighbor,
+                        const int offset_x,
+                        const int offset_y,
+                        const int height,
+                        const int neighbor_height)
+  {
+    if (offset_y == 0){
+      uint64_t edge = (offset_x > 0) ? node.high_x : node.low_x;
+      uint64_t neighbor_edge = (offset_x > 0) ? neighbor.low_x : neighbor.high_x;
+
+      return ((edge | (edge << 1) | (edge >> 1)) & neighbor_edge) != 0;
+    }
+
+    if (offset_x == 0){
+      uint64_t edge = (offset_y > 0) ? node.high_y : node.low_y;
+      uint64_t neighbor_edge = (offset_y > 0) ? neighbor.low_y : neighbor.high_y;
+
+      return ((edge | (edge << 1) | (edge >> 1)) & neighbor_edge) != 0;
+    }
+
+    // Diagonal blocks only share a corner
+    uint64_t corner = (offset_x > 0) ? node.high_x : node.low_x;
+    uint64_t neighbor_corner = (offset_x > 0) ? neighbor.low_x : neighbor.high_x;
+
+    if (offset_y > 0){
+      corner >>= height - 1;
+    }else{
+      neighbor_corner >>= neighbor_height - 1;
+    }
+
+    return (corner & neighbor_corner & 1) != 0;
+  }
+
+  bool addExplorationTransformHierarchical(grid_map::GridMap& grid_map,
+                                           const std::vector<grid_map::Index>& goal_points,
+                                           const grid_map::Index& start_index,
+                                           const int downsample_factor,
+                                           const int corridor_radius,
+                                           const float lethal_dist,
+                                           const float penalty_dist,
+                                           const std::string occupancy_layer,
+                                           const std::string dist_trans_layer,
+                                           const std::string expl_trans_layer,
+                                           ExploredRegion* explored_region,
+                                           TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    // Out of range starts are rejected below
+    if (!isDefaultStartIndex(grid_map) && grid_map::checkIfIndexInRange(start_index, grid_map.getSize())){
+      grid_map::GridMap unwrapped (unwrappedCopy(grid_map, {occupancy_layer, dist_trans_layer}));
+
+      if (!addExplorationTransformHierarchical(unwrapped, unwrapIndices(grid_map, goal_points), unwrapIndex(grid_map, start_index),
+                                               downsample_factor, corridor_radius, lethal_dist, penalty_dist,
+                                               occupancy_layer, dist_trans_layer, expl_trans_layer, explored_region, workspace))
+        return false;
+
+      copyLayerWrapped(unwrapped, expl_trans_layer, grid_map);
+      return true;
+    }
+
+    if (!grid_map.exists(dist_trans_layer))
+      return false;
+
+    if (downsample_factor < 1 || downsample_factor > 64 || corridor_radius < 0)
+      return false;
+
+    const int size_x = grid_map.getSize()(0);
+    const int size_y = grid_map.getSize()(1);
+
+    if (start_index(0) < 0 || start_index(0) >= size_x ||
+        start_index(1) < 0 || start_index(1) >= size_y){
+      return false;
+    }
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    // Cells outside the corridor are masked in these codes later on
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes);
+
+    const grid_map::Matrix& dist_data (grid_map[dist_trans_layer]);
+
+    const float max_val = std::numeric_limits<float>::max();
+
+    const int factor = downsample_factor;
+    const int coarse_size_x = (size_x + factor - 1) / factor;
+    const int coarse_size_y = (size_y + factor - 1) / factor;
+
+    const int offsets_x[8] = {-1,  0,  1, -1, 1, -1, 0, 1};
+    const int offsets_y[8] = {-1, -1, -1,  0, 0,  1, 1, 1};
+
+    const NeighborOffsets neighbors (size_x);
+
+    const unsigned char* codes = occupancy_codes.data();
+    const float* dist = dist_data.data();
+
+    // Cells whose node is needed later (the start and the goals with their
+    // neighbors), sorted by block so they are resolved during labeling
+    std::vector<std::pair<int, int> > query_cells;
+
+    query_cells.push_back(std::make_pair(start_index(0) / factor + (start_index(1) / factor) * coarse_size_x,
+                                         start_index(0) + start_index(1) * size_x));
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      int index = goal_points[i](0) + goal_points[i](1) * size_x;
+
+      for (int j = -1; j < 8; ++j){
+        if ((j >= 0) && (codes[index] & BORDER_CELL))
+          break;
+
+        int x = goal_points[i](0) + ((j < 0) ? 0 : offsets_x[j]);
+        int y = goal_points[i](1) + ((j < 0) ? 0 : offsets_y[j]);
+
+        query_cells.push_back(std::make_pair(x / factor + (y / factor) * coarse_size_x, x + y * size_x));
+      }
+    }
+
+    std::sort(query_cells.begin(), query_cells.end());
+    query_cells.erase(std::unique(query_cells.begin(), query_cells.end()), query_cells.end());
+
+    std::vector<int> query_nodes (query_cells.size(), -1);
+
+    // Coarse nodes are the 8-connected components of traversable cells
+    // within each block, so walls thinner than a block are kept. Border
+    // cells are never expanded and do not belong to any node. Blocks are
+    // flood filled on one bit mask per row.
+    std::vector<CoarseNode> nodes;
+    std::vector<int> block_nodes (coarse_size_x * coarse_size_y + 1, 0);
+
+    uint64_t free_rows[64];
+    uint64_t component[64];
+
+    size_t next_query = 0;
+
+    for (int block_y = 0; block_y < coarse_size_y; ++block_y){
+      for (int block_x = 0; block_x < coarse_size_x; ++block_x){
+        const int block = block_x + block_y * coarse_size_x;
+        const int min_x = block_x * factor;
+        const int min_y = block_y * factor;
+        const int width = std::min(size_x, min_x + factor) - min_x;
+        const int height = std::min(size_y, min_y + factor) - min_y;
+
+        block_nodes[block] = nodes.size();
+
+        while ((next_query < query_cells.size()) && (query_cells[next_query].first < block)){
+          ++next_query;
+        }
+
+        for (int row = 0; row < height; ++row){
+          const int row_index = min_x + (min_y + row) * size_x;
+          uint64_t bits = 0;
+
+          for (int col = 0; col < width; ++col){
+            if ((codes[row_index + col] == FREE_CELL) && (dist[row_index + col] >= lethal_dist))
+              bits |= uint64_t(1) << col;
+          }
+
+          free_rows[row] = bits;
+        }
+
+        for (int seed_row = 0; seed_row < height; ++seed_row){
+          while (free_rows[seed_row]){
+            std::fill(component, component + height, uint64_t(0));
+            component[seed_row] = free_rows[seed_row] & (~free_rows[seed_row] + 1);
+            free_rows[seed_row] &= ~component[seed_row];
+
+            bool grown = true;
+
+            while (grown){
+              grown = false;
+
+              for (int row = 0; row < height; ++row){
+                grown |= growComponentRow(component, free_rows, row, height);
+              }
+
+              for (int row = height - 1; row >= 0; --row){
+                grown |= growComponentRow(component, free_rows, row, height);
+              }
+            }
+
+            CoarseNode node;
+            node.block = block;
+            node.largest_dist = 0.0;
+            node.low_x = 0;
+            node.high_x = 0;
+            node.low_y = component[0];
+            node.high_y = component[height - 1];
+
+            for (int row = 0; row < height; ++row){
+              const int row_index = min_x + (min_y + row) * size_x;
+              uint64_t bits = component[row];
+
+              node.low_x |= (bits & 1) << row;
+              node.high_x |= ((bits >> (width - 1)) & 1) << row;
+
+              while (bits){
+                node.largest_dist = std::max(node.largest_dist, dist[row_index + __builtin_ctzll(bits)]);
+                bits &= bits - 1;
+              }
+            }
+
+            for (size_t i = next_query; (i < query_cells.size()) && (query_cells[i].first == block); ++i){
+              int row = query_cells[i].second / size_x - min_y;
+              int col = query_cells[i].second % size_x - min_x;
+
+              if ((component[row] >> col) & 1)
+                query_nodes[i] = nodes.size();
+            }
+
+            nodes.push_back(node);
+          }
+        }
+      }
+    }
+
+    block_nodes[coarse_size_x * coarse_size_y] = nodes.size();
+
+    const int num_nodes = nodes.size();
+
+    // Nodes of neighboring blocks are linked if their cells touch across the
+    // shared block edge or corner
+    std::vector<int> edge_begin (num_nodes + 1, 0);
+    std::vector<int> edge_nodes;
+
+    for (int node = 0; node < num_nodes; ++node){
+      const int block_x = nodes[node].block % coarse_size_x;
+      const int block_y = nodes[node].block / coarse_size_x;
+      const int height = std::min(size_y, (block_y + 1) * factor) - block_y * factor;
+
+      for (int i = 0; i < 8; ++i){
+        int x = block_x + offsets_x[i];
+        int y = block_y + offsets_y[i];
+
+        if (x < 0 || x >= coarse_size_x || y < 0 || y >= coarse_size_y)
+          continue;
+
+        const int neighbor_block = x + y * coarse_size_x;
+        const int neighbor_height = std::min(size_y, (y + 1) * factor) - y * factor;
+
+        for (int neighbor_node = block_nodes[neighbor_block]; neighbor_node < block_nodes[neighbor_block + 1]; ++neighbor_node){
+          if (coarseNodesTouch(nodes[node], nodes[neighbor_node], offsets_x[i], offsets_y[i], height, neighbor_height))
+            edge_nodes.push_back(neighbor_node);
+        }
+      }
+
+      edge_begin[node + 1] = edge_nodes.size();
+    }
+
+    // Coarse transform. Entering a node takes about factor fine steps,
+    // each with the smallest penalty found in the node.
+    const float adjacent_dist = 0.955;
+    const float diagonal_dist = 1.3693;
+
+    std::vector<float> node_expl (num_nodes, max_val);
+
+    typedef std::pair<float, int> QueueEntry;
+
+    std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > queue;
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      int index = goal_points[i](0) + goal_points[i](1) * size_x;
+
+      // Goals need not be traversable themselves, they are expanded anyway
+      for (int j = -1; j < 8; ++j){
+        if ((j >= 0) && (codes[index] & BORDER_CELL))
+          break;
+
+        int x = goal_points[i](0) + ((j < 0) ? 0 : offsets_x[j]);
+        int y = goal_points[i](1) + ((j < 0) ? 0 : offsets_y[j]);
+
+        std::pair<int, int> query (x / factor + (y / factor) * coarse_size_x, x + y * size_x);
+
+        int node = query_nodes[std::lower_bound(query_cells.begin(), query_cells.end(), query) - query_cells.begin()];
+
+        if ((node != -1) && (node_expl[node] > 0.0f)){
+          node_expl[node] = 0.0;
+          queue.push(QueueEntry(0.0f, node));
+        }
+      }
+    }
+
+    while (!queue.empty()){
+      QueueEntry entry (queue.top());
+      queue.pop();
+
+      int node = entry.second;
+
+      if (entry.first > node_expl[node])
+        continue;
+
+      int block_x = nodes[node].block % coarse_size_x;
+      int block_y = nodes[node].block / coarse_size_x;
+
+      for (int i = edge_begin[node]; i < edge_begin[node + 1]; ++i){
+        int neighbor_node = edge_nodes[i];
+
+        int neighbor_block_x = nodes[neighbor_node].block % coarse_size_x;
+        int neighbor_block_y = nodes[neighbor_node].block / coarse_size_x;
+
+        float step_cost = ((neighbor_block_x != block_x) && (neighbor_block_y != block_y)) ? diagonal_dist : adjacent_dist;
+
+        float neighbor_dist = nodes[neighbor_node].largest_dist;
+
+        if (neighbor_dist < penalty_dist){
+          float add_cost = (penalty_dist - neighbor_dist);
+          step_cost += add_cost * add_cost;
+        }
+
+        float cost = entry.first + factor * step_cost;
+
+        if (node_expl[neighbor_node] > cost){
+          node_expl[neighbor_node] = cost;
+          queue.push(QueueEntry(cost, neighbor_node));
+        }
+      }
+    }
+
+    // Coarse path by steepest descent, its blocks dilated into the corridor
+    std::vector<unsigned char> corridor (coarse_size_x * coarse_size_y, 0);
+
+    grid_map::Index corridor_min (coarse_size_x, coarse_size_y);
+    grid_map::Index corridor_max (-1, -1);
+
+    std::pair<int, int> start_query (start_index(0) / factor + (start_index(1) / factor) * coarse_size_x,
+                                     start_index(0) + start_index(1) * size_x);
+
+    int path_node = query_nodes[std::lower_bound(query_cells.begin(), query_cells.end(), start_query) - query_cells.begin()];
+
+    bool coarse_path_found = (path_node != -1) && (node_expl[path_node] != max_val);
+
+    while (coarse_path_found){
+      grid_map::Index block (nodes[path_node].block % coarse_size_x, nodes[path_node].block / coarse_size_x);
+
+      for (int y = std::max(0, block(1) - corridor_radius); y <= std::min(coarse_size_y-1, block(1) + corridor_radius); ++y){
+        for (int x = std::max(0, block(0) - corridor_radius); x <= std::min(coarse_size_x-1, block(0) + corridor_radius); ++x){
+          corridor[x + y * coarse_size_x] = 1;
+        }
+      }
+
+      corridor_min = corridor_min.min(block - corridor_radius).max(grid_map::Index(0, 0));
+      corridor_max = corridor_max.max(block + corridor_radius).min(grid_map::Index(coarse_size_x-1, coarse_size_y-1));
+
+      float lowest_val = node_expl[path_node];
+
+      if (lowest_val == 0.0f)
+        break;
+
+      int lowest_node = path_node;
+
+      for (int i = edge_begin[path_node]; i < edge_begin[path_node + 1]; ++i){
+        if (node_expl[edge_nodes[i]] < lowest_val){
+          lowest_val = node_expl[edge_nodes[i]];
+          lowest_node = edge_nodes[i];
+        }
+      }
+
+      if (lowest_node == path_node)
+        break;
+
+      path_node = lowest_node;
+    }
+
+    ExploredRegion region;
+    ExplorationTransformStats stats;
+
+    grid_map::Matrix& expl_layer (resetLayer(grid_map, expl_trans_layer, max_val));
+
+    if (coarse_path_found){
+      // Cells outside the corridor are treated as occupied
+      for (int idx_y = 0; idx_y < size_y; ++idx_y){
+        const unsigned char* corridor_row = &corridor[(idx_y / factor) * coarse_size_x];
+
+        for (int idx_x = 0; idx_x < size_x; ++idx_x){
+          if (!corridor_row[idx_x / factor]){
+            unsigned char& code = occupancy_codes(idx_x, idx_y);
+            code = (code & BORDER_CELL) | OCCUPIED_CELL;
+          }
+        }
+      }
+
+      std::vector<grid_map::Index> corridor_goals;
+
+      for (size_t i = 0; i < goal_points.size(); ++i){
+        const grid_map::Index& point = goal_points[i];
+
+        if (corridor[point(0) / factor + (point(1) / factor) * coarse_size_x])
+          corridor_goals.push_back(point);
+      }
+
+      propagateExplorationBucketed(occupancy_codes,
+                                   dist_data,
+                                   expl_layer,
+                                   corridor_goals,
+                                   lethal_dist,
+                                   penalty_dist,
+                                   &stats,
+                                   workspace->buckets,
+                                   workspace->cell_state);
+
+      region.min_index = corridor_min * factor;
+      region.max_index = ((corridor_max + 1) * factor - 1).min(grid_map::Index(size_x-1, size_y-1));
+    }
+
+    // The coarse path may lead through blocks whose traversable cells are
+    // not connected at full resolution
+    if (expl_layer(start_index(0), start_index(1)) == max_val){
+      addExplorationTransformBucketed(grid_map,
+                                      goal_points,
+                                      lethal_dist,
+                                      penalty_dist,
+                                      occupancy_layer,
+                                      dist_trans_layer,
+                                      expl_trans_layer,
+                                      &stats,
+                                      workspace);
+
+      region.min_index = grid_map::Index(0, 0);
+      region.max_index = grid_map::Index(size_x-1, size_y-1);
+    }
+
+    if (explored_region){
+      const grid_map::Matrix& expl_result (grid_map[expl_trans_layer]);
+
+      region.expanded_cells = stats.settled_cells;
+      region.reached_cells = (expl_result.block(region.min_index(0),
+                                                region.min_index(1),
+                                                region.max_index(0) - region.min_index(0) + 1,
+                                                region.max_index(1) - region.min_index(1) + 1).array() != max_val).count();
+      region.start_reached = expl_result(start_index(0), start_index(1)) != max_val;
+
+      *explored_region = region;
+    }
+
+    return true;
+  }
+
+  void collectReachableCells(const OccupancyCodes& occupancy_codes,
+                             const grid_map::Index& seed_point,
+                             std::vector<unsigned char>& cell_state,
+                             std::vector<grid_map::Index>& obstacle_cells,
+                             std::vector<grid_map::Index>& frontier_cells,
+                             CellQueue& point_queue)
+  {
+    cell_state.assign(occupancy_codes.size(), 0);
+
+    const NeighborOffsets neighbors (occupancy_codes.rows(), occupancy_codes.cols());
+
+    point_queue.reset(occupancy_codes.size());
+
+    cell_state[seed_point(0) + seed_point(1) * occupancy_codes.rows()] = REACHABLE_CELL;
+
+    pushSeedCells(occupancy_codes, std::vector<grid_map::Index>(1, seed_point), point_queue);
+
+    int wrapped_offsets[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      const int* offsets = neighbors.offsetsAt(occupancy_codes.data()[index], index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        touchReachabilityCell(occupancy_codes,
+                              cell_state,
+                              index,
+                              index + offsets[i],
+                              obstacle_cells,
+                              frontier_cells,
+                              point_queue);
+      }
+    }
+  }
+
+  bool computeTransforms(grid_map::GridMap& grid_map,
+                         const grid_map::Index& seed_point,
+                         const std::vector<grid_map::Index>& goal_points,
+                         std::vector<grid_map::Index>& obstacle_cells,
+                         std::vector<grid_map::Index>& frontier_cells,
+                         const int output_layers,
+                         const float lethal_dist,
+                         const float penalty_dist,
+                         const std::string occupancy_layer,
+                         const std::string dist_trans_layer,
+                         const std::string expl_trans_layer,
+                         TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    // Built once and shared by all stages
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    const float max_val = std::numeric_limits<float>::max();
+
+    obstacle_cells.clear();
+    frontier_cells.clear();
+
+    // One queue for the whole map, reused by the later stages
+    CellQueue point_queue (workspace->queue_buffer);
+
+    // Reachability only needs one byte per cell instead of a float layer
+    collectReachableCells(occupancy_codes,
+                          seed_point,
+                          workspace->cell_state,
+                          obstacle_cells,
+                          frontier_cells,
+                          point_queue);
+
+    // Distance transform goes to the map if requested, scratch otherwise
+    grid_map::Matrix* dist_layer = 0;
+
+    if (output_layers & DISTANCE_TRANSFORM_LAYER){
+      dist_layer = &resetLayer(grid_map, dist_trans_layer, max_val);
+    }else if (output_layers & EXPLORATION_TRANSFORM_LAYER){
+      dist_layer = &workspace->dist_scratch;
+      dist_layer->setConstant(occupancy_codes.rows(), occupancy_codes.cols(), max_val);
+    }else{
+      return true;
+    }
+
+    grid_map::Matrix& dist_data (*dist_layer);
+
+    point_queue.reset(dist_data.size());
+
+    for (size_t i = 0; i < obstacle_cells.size(); ++i){
+      const grid_map::Index& point = obstacle_cells[i];
+      dist_data(point(0), point(1)) = 0.0;
+    }
+
+    pushSeedCells(occupancy_codes, obstacle_cells, point_queue);
+
+    propagateDistance(occupancy_codes, dist_data, point_queue);
+
+    if (!(output_layers & EXPLORATION_TRANSFORM_LAYER))
+      return true;
+
+    propagateExplorationBucketed(occupancy_codes,
+                                 dist_data,
+                                 resetLayer(grid_map, expl_trans_layer, max_val),
+                                 goal_points.empty() ? frontier_cells : goal_points,
+                                 lethal_dist,
+                                 penalty_dist,
+                                 0,
+                                 workspace->buckets,
+                                 workspace->cell_state);
+
+    return true;
+  }
+
+  void quantizeField(const grid_map::Matrix& data,
+                     QuantizedField& field)
+  {
+    field.data.resize(data.rows(), data.cols());
+
+    const float inv_scale = 1.0f / field.scale;
+
+    for (int i = 0; i < data.size(); ++i){
+      float val = data.data()[i];
+
+      if (val == std::numeric_limits<float>::max()){
+        field.data.data()[i] = QUANTIZED_UNREACHED;
+      }else{
+        field.data.data()[i] = static_cast<uint16_t>(std::min(std::max(0.0f, val * inv_scale + 0.5f),
+                                                              static_cast<float>(QUANTIZED_MAX_VALUE)));
+      }
+    }
+  }
+
+  bool addQuantizedFieldLayer(grid_map::GridMap& grid_map,
+                              const QuantizedField& field,
+                              const std::string layer)
+  {
+    if ((field.data.rows() != grid_map.getSize()(0)) || (field.data.cols() != grid_map.getSize()(1)))
+      return false;
+
+    grid_map_cv_bridge::getOrAddLayer(grid_map, layer) = field.view();
+
+    return true;
+  }
+
+  // Step costs of NeighborOffsets in multiples of scale, at least 1
+  void quantizeStepCosts(const NeighborOffsets& neighbors,
+                         const float scale,
+                         unsigned int* step_costs)
+  {
+    for (int i = 0; i < 8; ++i){
+      step_costs[i] = std::max(1u, static_cast<unsigned int>(neighbors.costs[i] / scale + 0.5f));
+    }
+  }
+
+  void propagateDistanceQuantized(const OccupancyCodes& occupancy_codes,
+                                  QuantizedField& dist_field,
+                                  CellQueue& point_queue)
+  {
+    const NeighborOffsets neighbors (dist_field.data.rows(), dist_field.data.cols());
+
+    unsigned int step_costs[8];
+    quantizeStepCosts(neighbors, dist_field.scale, step_costs);
+
+    const unsigned char* codes = occupancy_codes.data();
+    uint16_t* dist_data = dist_field.data.data();
+
+    int wrapped_offsets[8];
+
+    while (!point_queue.empty()){
+      int index = point_queue.pop();
+
+      unsigned int current_val = dist_data[index];
+
+      const int* offsets = neighbors.offsetsAt(codes[index], index, wrapped_offsets);
+
+      for (int i = 0; i < 8; ++i){
+        touchQuantizedDistCell(codes,
+                               dist_data,
+                               index + offsets[i],
+                               current_val,
+                               step_costs[i],
+                               point_queue);
+      }
+    }
+  }
+
+  bool computeDistanceTransformQuantized(const grid_map::GridMap& grid_map,
+                                         const grid_map::Index& seed_point,
+                                         std::vector<grid_map::Index>& obstacle_cells,
+                                         std::vector<grid_map::Index>& frontier_cells,
+                                         QuantizedField& dist_field,
+                                         const std::string occupancy_layer,
+                                         TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if (!(dist_field.scale > 0.0f))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    obstacle_cells.clear();
+    frontier_cells.clear();
+
+    CellQueue point_queue (workspace->queue_buffer);
+
+    collectReachableCells(occupancy_codes,
+                          seed_point,
+                          workspace->cell_state,
+                          obstacle_cells,
+                          frontier_cells,
+                          point_queue);
+
+    dist_field.data.setConstant(occupancy_codes.rows(), occupancy_codes.cols(), QUANTIZED_UNREACHED);
+
+    point_queue.reset(dist_field.data.size());
+
+    for (size_t i = 0; i < obstacle_cells.size(); ++i){
+      const grid_map::Index& point = obstacle_cells[i];
+      dist_field.data(point(0), point(1)) = 0;
+    }
+
+    pushSeedCells(occupancy_codes, obstacle_cells, point_queue);
+
+    propagateDistanceQuantized(occupancy_codes, dist_field, point_queue);
+
+    return true;
+  }
+
+  bool computeExplorationTransformQuantized(const grid_map::GridMap& grid_map,
+                                            const std::vector<grid_map::Index>& goal_points,
+                                            const QuantizedField& dist_field,
+                                            QuantizedField& expl_field,
+                                            const float lethal_dist,
+                                            const float penalty_dist,
+                                            const std::string occupancy_layer,
+                                            ExplorationTransformStats* stats,
+                                            TransformWorkspace* workspace)
+  {
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    if ((dist_field.data.rows() != grid_map.getSize()(0)) || (dist_field.data.cols() != grid_map.getSize()(1)))
+      return false;
+
+    if (!(dist_field.scale > 0.0f) || !(expl_field.scale > 0.0f))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    // Penalty by quantized distance, so the search never converts to float
+    const unsigned int blocked = std::numeric_limits<unsigned int>::max();
+
+    float max_dist = std::max(lethal_dist, penalty_dist);
+    size_t num_cell_costs = std::min(static_cast<size_t>(std::ceil(max_dist / dist_field.scale)) + 1,
+                                     static_cast<size_t>(QUANTIZED_UNREACHED));
+
+    std::vector<unsigned int> cell_costs (num_cell_costs, 0);
+    unsigned int max_cell_cost = 0;
+
+    for (size_t i = 0; i < num_cell_costs; ++i){
+      float dist = i * dist_field.scale;
+
+      if (dist < lethal_dist){
+        cell_costs[i] = blocked;
+      }else if (dist < penalty_dist){
+        float add_cost = (penalty_dist - dist);
+        cell_costs[i] = static_cast<unsigned int>(add_cost * add_cost / expl_field.scale + 0.5f);
+        max_cell_cost = std::max(max_cell_cost, cell_costs[i]);
+      }
+    }
+
+    expl_field.data.setConstant(occupancy_codes.rows(), occupancy_codes.cols(), QUANTIZED_UNREACHED);
+
+    const int size_x = occupancy_codes.rows();
+
+    const NeighborOffsets neighbors (size_x, occupancy_codes.cols());
+
+    unsigned int step_costs[8];
+    quantizeStepCosts(neighbors, expl_field.scale, step_costs);
+
+    // Integer costs make the buckets exact, a bucket holds one step of the
+    // smallest cost
+    unsigned int bucket_width = *std::min_element(step_costs, step_costs + 8);
+    unsigned int max_step_cost = *std::max_element(step_costs, step_costs + 8) + max_cell_cost;
+
+    size_t num_buckets = max_step_cost / bucket_width + 2;
+
+    std::vector<std::vector<int> >& buckets (workspace->buckets);
+    buckets.resize(num_buckets);
+
+    for (size_t i = 0; i < num_buckets; ++i){
+      buckets[i].clear();
+    }
+
+    std::vector<unsigned char>& settled (workspace->cell_state);
+    settled.assign(occupancy_codes.size(), 0);
+
+    size_t num_pushed = 0;
+    size_t num_settled = 0;
+
+    for (size_t i = 0; i < goal_points.size(); ++i){
+      const grid_map::Index& point = goal_points[i];
+      expl_field.data(point(0), point(1)) = 0;
+
+      if (!(occupancy_codes(point(0), point(1)) & BORDER_CELL)){
+        buckets[0].push_back(point(0) + point(1) * size_x);
+        ++num_pushed;
+      }
+    }
+
+    const unsigned char* codes = occupancy_codes.data();
+    const uint16_t* dist = dist_field.data.data();
+    uint16_t* expl = expl_field.data.data();
+
+    size_t num_queued = num_pushed;
+
+    int wrapped_offsets[8];
+
+    for (size_t bucket = 0; num_queued > 0; ++bucket){
+      std::vector<int>& current_bucket = buckets[bucket % num_buckets];
+
+      while (!current_bucket.empty()){
+        int index = current_bucket.back();
+        current_bucket.pop_back();
+        --num_queued;
+
+        if (settled[index])
+          continue;
+
+        settled[index] = 1;
+        ++num_settled;
+
+        unsigned int current_val = expl[index];
+
+        size_t pushed_before = num_pushed;
+
+        const int* offsets = neighbors.offsetsAt(codes[index], index, wrapped_offsets);
+
+        for (int i = 0; i < 8; ++i){
+          touchQuantizedExplorationCell(codes,
+                                        dist,
+                                        &cell_costs[0],
+                                        num_cell_costs,
+                                        expl,
+                                        index + offsets[i],
+                                        current_val,
+                                        step_costs[i],
+                                        bucket_width,
+                                        buckets,
+                                        num_pushed);
+        }
+
+        num_queued += num_pushed - pushed_before;
+      }
+    }
+
+    if (stats){
+      stats->pushed_cells = num_pushed;
+      stats->settled_cells = num_settled;
+    }
+
+    return true;
+  }
+
+  bool collectReachableObstacleCells(grid_map::GridMap& grid_map,
+                                     const grid_map::Index& seed_point,
+                                     std::vector<grid_map::Index>& obstacle_cells,
+                                     std::vector<grid_map::Index>& frontier_cells,
+                                     const std::string occupancy_layer,
+                                     const std::string dist_seed_layer,
+                                     TransformWorkspace* workspace)
+  {
+
+    if (!grid_map.exists(occupancy_layer))
+      return false;
+
+    TransformWorkspace local_workspace;
+
+    if (!workspace)
+      workspace = &local_workspace;
+
+    OccupancyCodes& occupancy_codes (workspace->occupancy_codes);
+    buildOccupancyCodes(grid_map[occupancy_layer], occupancy_codes, 1, grid_map.getStartIndex());
+
+    CellQueue point_queue (workspace->queue_buffer);
+
+    searchReachableObstacleCells(occupancy_codes,
+                                 resetLayer(grid_map, dist_seed_layer, std::numeric_limits<float>::max()),
+                                 seed_point,
+                                 obstacle_cells,
+                                 frontier_cells,
+                                 point_queue);
+
     //std::cout << "o: " << obstacle_cells.size() << " f: " << frontier_cells.size() << "\n";
 
     return true;
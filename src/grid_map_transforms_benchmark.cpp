@@ -0,0 +1,207 @@
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace grid_map_transforms;
+
+namespace{
+
+  /*
+   * Counter of the calling thread (user space only) read with
+   * perf_event_open. Hardware events need a PMU, which virtual machines
+   * often do not expose; the counter is not open then.
+   */
+  class PerfCounter
+  {
+  public:
+    PerfCounter(const uint32_t type,
+                const uint64_t config)
+    {
+      perf_event_attr attr;
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = type;
+      attr.config = config;
+      attr.disabled = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      fd_ = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~PerfCounter()
+    {
+      if (fd_ >= 0)
+        close(fd_);
+    }
+
+    void start()
+    {
+      if (fd_ < 0)
+        return;
+
+      ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    long long stop()
+    {
+      long long count = -1;
+
+      if (fd_ < 0)
+        return count;
+
+      ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+
+      if (read(fd_, &count, sizeof(count)) != sizeof(count))
+        count = -1;
+
+      return count;
+    }
+
+  protected:
+    int fd_;
+
+  private:
+    PerfCounter(const PerfCounter&);
+    PerfCounter& operator=(const PerfCounter&);
+  };
+
+  uint64_t cacheEvent(const uint64_t cache)
+  {
+    return cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+  }
+
+  struct CounterSet
+  {
+    CounterSet()
+      : cache_misses(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES)
+      , l1d_misses(PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_L1D))
+      , dtlb_misses(PERF_TYPE_HW_CACHE, cacheEvent(PERF_COUNT_HW_CACHE_DTLB))
+      , page_faults(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN)
+    {}
+
+    PerfCounter cache_misses;
+    PerfCounter l1d_misses;
+    PerfCounter dtlb_misses;
+    PerfCounter page_faults;
+  };
+
+  void printCount(const long long count)
+  {
+    if (count < 0)
+      std::printf(" %14s", "n/a");
+    else
+      std::printf(" %14lld", count);
+  }
+
+  /*
+   * Runs function twice, so workspaces are allocated before the measured
+   * run, and prints wall time and counters of the second run.
+   */
+  template <typename Function>
+  void measure(const char* name,
+               CounterSet& counters,
+               Function function)
+  {
+    function();
+
+    counters.cache_misses.start();
+    counters.l1d_misses.start();
+    counters.dtlb_misses.start();
+    counters.page_faults.start();
+
+    const std::chrono::steady_clock::time_point start_time = std::chrono::steady_clock::now();
+
+    function();
+
+    const double wall_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start_time).count();
+
+    const long long page_faults = counters.page_faults.stop();
+    const long long dtlb_misses = counters.dtlb_misses.stop();
+    const long long l1d_misses = counters.l1d_misses.stop();
+    const long long cache_misses = counters.cache_misses.stop();
+
+    std::printf("%-32s %10.1f", name, wall_ms);
+    printCount(cache_misses);
+    printCount(l1d_misses);
+    printCount(dtlb_misses);
+    printCount(page_faults);
+    std::printf("\n");
+  }
+
+}
+
+/*
+ * Compares the column-major and tiled distance and exploration transforms
+ * on a size x size map with random obstacles:
+ *
+ *   grid_map_transforms_benchmark [size] [obstacle_fraction]
+ *
+ * Prints wall time, last level cache, L1 data and data TLB read misses
+ * and minor page faults of each transform. Counters that cannot be
+ * opened are printed as n/a.
+ */
+int main(int argc, char** argv)
+{
+  const int size = (argc > 1) ? std::atoi(argv[1]) : 8000;
+  const double obstacle_fraction = (argc > 2) ? std::atof(argv[2]) : 0.0025;
+
+  if (size < 3){
+    std::fprintf(stderr, "Map size must be at least 3\n");
+    return 1;
+  }
+
+  grid_map::GridMap grid_map (std::vector<std::string>(1, "occupancy"));
+  grid_map.setGeometry(grid_map::Length(size * 0.05, size * 0.05), 0.05);
+
+  std::mt19937 rng (1);
+  std::uniform_real_distribution<double> uniform (0.0, 1.0);
+
+  grid_map::Matrix& occupancy = grid_map["occupancy"];
+
+  for (int i = 0; i < occupancy.size(); ++i){
+    occupancy.data()[i] = (uniform(rng) < obstacle_fraction) ? 100.0f : 0.0f;
+  }
+
+  const grid_map::Index seed_point (size / 2, size / 2);
+  const std::vector<grid_map::Index> goal_points (1, grid_map::Index(1, 1));
+
+  occupancy(seed_point(0), seed_point(1)) = 0.0f;
+  occupancy(1, 1) = 0.0f;
+
+  std::vector<grid_map::Index> obstacle_cells, frontier_cells;
+  TransformWorkspace workspace, tiled_workspace;
+
+  CounterSet counters;
+
+  std::printf("%d x %d cells, obstacle fraction %g\n", size, size, obstacle_fraction);
+  std::printf("%-32s %10s %14s %14s %14s %14s\n", "transform", "wall ms", "cache misses", "L1D misses", "dTLB misses", "page faults");
+
+  measure("addDistanceTransform", counters, [&]{
+    addDistanceTransform(grid_map, seed_point, obstacle_cells, frontier_cells, "occupancy", "distance_transform", &workspace);
+  });
+
+  measure("addDistanceTransformTiled", counters, [&]{
+    addDistanceTransformTiled(grid_map, seed_point, obstacle_cells, frontier_cells, "occupancy", "distance_transform", &tiled_workspace);
+  });
+
+  measure("addExplorationTransformBucketed", counters, [&]{
+    addExplorationTransformBucketed(grid_map, goal_points, 6.0, 12.0, "occupancy", "distance_transform", "exploration_transform", 0, &workspace);
+  });
+
+  measure("addExplorationTransformTiled", counters, [&]{
+    addExplorationTransformTiled(grid_map, goal_points, 6.0, 12.0, "occupancy", "distance_transform", "exploration_transform", 0, &tiled_workspace);
+  });
+
+  return 0;
+}
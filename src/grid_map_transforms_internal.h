@@ -0,0 +1,424 @@
+#pragma once
+
+/*
+ * Search kernels and queues shared by the transform implementations
+ * (grid_map_transforms.cpp, grid_map_mapped_transforms.cpp). Not part of
+ * the installed headers.
+ */
+
+#include <grid_map_proc/grid_map_transforms.h>
+#include <grid_map_proc/grid_map_transform_policies.h>
+
+#include <limits>
+#include <queue>
+#include <vector>
+
+namespace grid_map_transforms{
+
+    /*
+     * FIFO of linear cell indices in a ring buffer with room for one entry
+     * per map cell, allocated once per search. Like the std::queue it
+     * replaces, a cell improved again while waiting is queued a second time;
+     * skipping it instead expands cells later and made label correcting
+     * searches with penalty costs several times slower. Grows by doubling in
+     * the rare case the live entries exceed the map size.
+     */
+    class CellQueue
+    {
+    public:
+      CellQueue()
+        : buffer_(own_buffer_)
+        , head_(0)
+        , size_(0)
+      {}
+
+      // Queue in buffer, e.g. TransformWorkspace::queue_buffer
+      explicit CellQueue(std::vector<int>& buffer)
+        : buffer_(buffer)
+        , head_(0)
+        , size_(0)
+      {}
+
+      void reset(const size_t num_cells)
+      {
+        buffer_.resize(std::max(num_cells, static_cast<size_t>(1)));
+        head_ = 0;
+        size_ = 0;
+      }
+
+      bool empty() const { return size_ == 0; }
+
+      void push(const int index)
+      {
+        if (size_ == buffer_.size())
+          grow();
+
+        size_t tail = head_ + size_;
+
+        if (tail >= buffer_.size())
+          tail -= buffer_.size();
+
+        buffer_[tail] = index;
+        ++size_;
+      }
+
+      int pop()
+      {
+        int index = buffer_[head_];
+
+        if (++head_ == buffer_.size())
+          head_ = 0;
+
+        --size_;
+        return index;
+      }
+
+    protected:
+      void grow()
+      {
+        std::vector<int> buffer (std::max(buffer_.size() * 2, static_cast<size_t>(1)));
+
+        for (size_t i = 0; i < size_; ++i){
+          buffer[i] = buffer_[(head_ + i) % buffer_.size()];
+        }
+
+        buffer_.swap(buffer);
+        head_ = 0;
+      }
+
+      std::vector<int> own_buffer_;
+      std::vector<int>& buffer_;
+      size_t head_;
+      size_t size_;
+
+    private:
+      CellQueue(const CellQueue&);
+      CellQueue& operator=(const CellQueue&);
+    };
+
+    /*
+     * Linear index offsets and step costs of the 8 neighbors of a cell in a
+     * column major map with size_x rows, in the order the searches visit them.
+     * size_y is only needed for circular buffers (offsetsAt).
+     */
+    struct NeighborOffsets
+    {
+      explicit NeighborOffsets(const int size_x, const int size_y = 1)
+        : size_x(size_x)
+        , size_y(size_y)
+      {
+        const float adjacent_dist = 0.955f;
+        const float diagonal_dist = 1.3693f;
+
+        int i = 0;
+
+        for (int y = -1; y <= 1; ++y){
+          for (int x = -1; x <= 1; ++x){
+            if ((x == 0) && (y == 0))
+              continue;
+
+            dx[i] = x;
+            dy[i] = y;
+            offsets[i] = x + y * size_x;
+            costs[i] = ((x != 0) && (y != 0)) ? diagonal_dist : adjacent_dist;
+            ++i;
+          }
+        }
+      }
+
+      // Offsets of the cell at index with occupancy code, wrapped_offsets is scratch
+      const int* offsetsAt(const unsigned char code,
+                           const int index,
+                           int* wrapped_offsets) const
+      {
+        if (!(code & WRAPPED_CELL))
+          return offsets;
+
+        wrappedOffsets(index, size_x, size_y, dx, dy, 8, wrapped_offsets);
+        return wrapped_offsets;
+      }
+
+      int size_x;
+      int size_y;
+      int dx[8];
+      int dy[8];
+      int offsets[8];
+      float costs[8];
+    };
+
+    /*
+     * Queues seed cells for expansion. Seeds on the map border keep their
+     * value but are not expanded, like all other border cells.
+     */
+    inline void pushSeedCells(const OccupancyCodes& occupancy_codes,
+                              const std::vector<grid_map::Index>& cells,
+                              CellQueue& point_queue)
+    {
+      for (size_t i = 0; i < cells.size(); ++i){
+        int index = cells[i](0) + cells[i](1) * occupancy_codes.rows();
+
+        if (!(occupancy_codes.data()[index] & BORDER_CELL))
+          point_queue.push(index);
+      }
+    }
+
+    // The kernels below work on linear indices. Cells flagged BORDER_CELL
+    // receive values but are never queued, so expanded cells always have
+    // all 8 neighbors inside the map.
+
+    inline void touchExplorationCell(const unsigned char* occupancy_codes,
+                              const float* dist_map,
+                         float* expl_trans_map,
+                         const int index,
+                         const float curr_val,
+                         const float add_cost,
+                         const float lethal_dist,
+                         const float penalty_dist,
+                         CellQueue& point_queue)
+    {
+      const unsigned char code = occupancy_codes[index];
+
+      //If not free at cell, return right away
+      if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+        return;
+
+      float dist = dist_map[index];
+
+      if (dist < lethal_dist)
+        return;
+
+      float cost = curr_val + add_cost;
+
+      if (dist < penalty_dist){
+        float add_cost = (penalty_dist - dist);
+        cost += add_cost * add_cost;
+      }
+
+      if (expl_trans_map[index] > cost){
+        expl_trans_map[index] = cost;
+
+        if (!(code & BORDER_CELL))
+          point_queue.push(index);
+      }
+    }
+
+    // Returns true if the value of the cell was lowered.
+    inline bool touchDistCell(const unsigned char* occupancy_codes,
+                         float* expl_trans_map,
+                         const int index,
+                         const float curr_val,
+                         const float add_cost,
+                         CellQueue& point_queue)
+    {
+      const unsigned char code = occupancy_codes[index];
+
+      //If not free at cell, return right away
+      if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+        return false;
+
+      float cost = curr_val + add_cost;
+
+      if (expl_trans_map[index] > cost){
+        expl_trans_map[index] = cost;
+
+        if (!(code & BORDER_CELL))
+          point_queue.push(index);
+
+        return true;
+      }
+      return false;
+    }
+
+    inline bool touchQuantizedDistCell(const unsigned char* occupancy_codes,
+                         uint16_t* dist_map,
+                         const int index,
+                         const unsigned int curr_val,
+                         const unsigned int add_cost,
+                         CellQueue& point_queue)
+    {
+      const unsigned char code = occupancy_codes[index];
+
+      //If not free at cell, return right away
+      if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+        return false;
+
+      unsigned int cost = std::min(curr_val + add_cost, static_cast<unsigned int>(QUANTIZED_MAX_VALUE));
+
+      if (dist_map[index] > cost){
+        dist_map[index] = cost;
+
+        if (!(code & BORDER_CELL))
+          point_queue.push(index);
+
+        return true;
+      }
+      return false;
+    }
+
+    /*
+     * cell_costs holds the penalty of a cell by its quantized distance,
+     * std::numeric_limits<unsigned int>::max() if it is lethal. Distances
+     * past the end of the table cost nothing.
+     */
+    inline void touchQuantizedExplorationCell(const unsigned char* occupancy_codes,
+                         const uint16_t* dist_map,
+                         const unsigned int* cell_costs,
+                         const unsigned int num_cell_costs,
+                         uint16_t* expl_trans_map,
+                         const int index,
+                         const unsigned int curr_val,
+                         const unsigned int add_cost,
+                         const unsigned int bucket_width,
+                         std::vector<std::vector<int> >& buckets,
+                         size_t& num_pushed)
+    {
+      const unsigned char code = occupancy_codes[index];
+
+      //If not free at cell, return right away
+      if ((code & OCCUPANCY_CODE_MASK) != FREE_CELL)
+        return;
+
+      unsigned int dist = dist_map[index];
+      unsigned int cost = curr_val + add_cost;
+
+      if (dist < num_cell_costs){
+        if (cell_costs[dist] == std::numeric_limits<unsigned int>::max())
+          return;
+
+        cost += cell_costs[dist];
+      }
+
+      // Out of range of the field, stays unreached
+      if (cost > QUANTIZED_MAX_VALUE)
+        return;
+
+      if (expl_trans_map[index] > cost){
+        expl_trans_map[index] = cost;
+
+        if (!(code & BORDER_CELL)){
+          buckets[(cost / bucket_width) % buckets.size()].push_back(index);
+          ++num_pushed;
+        }
+      }
+    }
+
+    /*
+     * Raise step of updateDistanceTransform. Neighbors that might have been
+     * derived from the raised cell are invalidated and raised in turn, the
+     * remaining valid ones are queued for lowering unless they are border
+     * cells.
+     */
+    inline void touchDistRaiseCell(const unsigned char* occupancy_codes,
+                         float* dist_map,
+                         const int index,
+                         const float raised_val,
+                         const float add_cost,
+                         std::queue<std::pair<int, float> >& raise_queue,
+                         CellQueue& lower_queue)
+    {
+      float dist = dist_map[index];
+
+      //No valid data or already raised
+      if (dist == std::numeric_limits<float>::max())
+        return;
+
+      //Might have been derived via raised cell, so invalidate as well
+      if ((dist > 0.0f) && (dist >= (raised_val + add_cost - 1e-4f))){
+        dist_map[index] = std::numeric_limits<float>::max();
+        raise_queue.push(std::make_pair(index, dist));
+      }else if (!(occupancy_codes[index] & BORDER_CELL)){
+        lower_queue.push(index);
+      }
+    }
+
+    enum ReachabilityState
+    {
+      REACHABLE_CELL = 1,
+      OBSTACLE_CELL = 2,
+      FRONTIER_CELL = 4
+    };
+
+    inline void touchReachabilityCell(const OccupancyCodes& occupancy_codes,
+                         std::vector<unsigned char>& cell_state,
+                         const int current_index,
+                         const int index,
+                         std::vector<grid_map::Index>& obstacle_cells,
+                         std::vector<grid_map::Index>& frontier_cells,
+                         CellQueue& point_queue)
+    {
+      const unsigned char code = occupancy_codes.data()[index];
+      unsigned char& state = cell_state[index];
+
+      // Free
+      if ((code & OCCUPANCY_CODE_MASK) == FREE_CELL){
+        if (state & REACHABLE_CELL){
+          return;
+        }else{
+          state |= REACHABLE_CELL;
+
+          if (!(code & BORDER_CELL))
+            point_queue.push(index);
+        }
+      // Occupied
+      }else if ((code & OCCUPANCY_CODE_MASK) == OCCUPIED_CELL){
+        if (state & OBSTACLE_CELL){
+          return;
+        }else{
+          state |= OBSTACLE_CELL;
+          obstacle_cells.push_back(grid_map::Index(index % occupancy_codes.rows(), index / occupancy_codes.rows()));
+        }
+      // Unknown
+      }else{
+        unsigned char& current_state = cell_state[current_index];
+
+        if (current_state & FRONTIER_CELL){
+          return;
+        }else{
+          current_state |= FRONTIER_CELL;
+          frontier_cells.push_back(grid_map::Index(current_index % occupancy_codes.rows(), current_index / occupancy_codes.rows()));
+        }
+      }
+    }
+
+    inline void touchObstacleSearchCell(const OccupancyCodes& occupancy_codes,
+                         float* expl_trans_map,
+                         const int current_index,
+                         const int index,
+                         std::vector<grid_map::Index>& obstacle_cells,
+                         std::vector<grid_map::Index>& frontier_cells,
+                         CellQueue& point_queue)
+    {
+      const unsigned char code = occupancy_codes.data()[index];
+
+      // Free
+      if ((code & OCCUPANCY_CODE_MASK) == FREE_CELL){
+        if (expl_trans_map[index] != std::numeric_limits<float>::max()){
+          return;
+        }else{
+          expl_trans_map[index] = -3.0;
+
+          if (!(code & BORDER_CELL))
+            point_queue.push(index);
+        }
+      // Occupied
+      }else if ((code & OCCUPANCY_CODE_MASK) == OCCUPIED_CELL){
+        if (expl_trans_map[index] == -1.0){
+          return;
+        }else{
+          expl_trans_map[index] = -1.0;
+          obstacle_cells.push_back(grid_map::Index(index % occupancy_codes.rows(), index / occupancy_codes.rows()));
+        }
+      // Unknown
+      }else{
+        if (expl_trans_map[current_index] == -2.0){
+          return;
+        }else{
+          expl_trans_map[current_index] = -2.0;
+          frontier_cells.push_back(grid_map::Index(current_index % occupancy_codes.rows(), current_index / occupancy_codes.rows()));
+        }
+      }
+
+
+    }
+
+} /* namespace */
@@ -0,0 +1,109 @@
+#include "grid_map_worker_pool.h"
+
+namespace grid_map_transforms{
+
+  WorkerPool& WorkerPool::shared()
+  {
+    static WorkerPool pool;
+    return pool;
+  }
+
+  WorkerPool::WorkerPool()
+    : job_(0)
+    , job_threads_(0)
+    , generation_(0)
+    , running_(0)
+    , stop_(false)
+  {}
+
+  WorkerPool::~WorkerPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      stop_ = true;
+    }
+
+    start_condition_.notify_all();
+
+    for (size_t i = 0; i < workers_.size(); ++i){
+      workers_[i].join();
+    }
+  }
+
+  void WorkerPool::run(const int num_threads,
+                       const std::function<void(int)>& function)
+  {
+    if (num_threads <= 1){
+      function(0);
+      return;
+    }
+
+    std::lock_guard<std::mutex> run_lock (run_mutex_);
+
+    // Thread 0 is the caller
+    while (static_cast<int>(workers_.size()) < num_threads - 1){
+      workers_.push_back(std::thread(&WorkerPool::workerLoop, this, static_cast<int>(workers_.size()) + 1));
+    }
+
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+      job_ = &function;
+      job_threads_ = num_threads;
+      running_ = num_threads - 1;
+      ++generation_;
+    }
+
+    start_condition_.notify_all();
+
+    function(0);
+
+    std::unique_lock<std::mutex> lock (mutex_);
+    done_condition_.wait(lock, [this]{ return running_ == 0; });
+    job_ = 0;
+  }
+
+  void WorkerPool::workerLoop(const int thread)
+  {
+    // Threads started for a job join it right away
+    unsigned int generation = 0;
+
+    {
+      std::lock_guard<std::mutex> lock (mutex_);
+
+      if (job_ && (thread < job_threads_))
+        generation = generation_ - 1;
+      else
+        generation = generation_;
+    }
+
+    while (true){
+      const std::function<void(int)>* job;
+
+      {
+        std::unique_lock<std::mutex> lock (mutex_);
+        start_condition_.wait(lock, [&]{ return stop_ || (generation != generation_); });
+
+        if (stop_)
+          return;
+
+        generation = generation_;
+
+        // Not needed for this job
+        if (thread >= job_threads_)
+          continue;
+
+        job = job_;
+      }
+
+      (*job)(thread);
+
+      {
+        std::lock_guard<std::mutex> lock (mutex_);
+
+        if (--running_ == 0)
+          done_condition_.notify_one();
+      }
+    }
+  }
+
+} /* namespace */
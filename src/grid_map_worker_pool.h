@@ -0,0 +1,86 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace grid_map_transforms{
+
+  /*
+   * Worker threads shared by the multi-threaded transforms and path
+   * extraction. Threads are started on first use (and when more are asked
+   * for than exist) and then wait on a condition variable between jobs, so
+   * searches that dispatch one job per phase do not create and join
+   * threads each time. One job runs at a time; concurrent callers wait for
+   * the running job to finish. Jobs must not call run themselves.
+   */
+  class WorkerPool
+  {
+  public:
+    // Pool used by the library, stopped at exit
+    static WorkerPool& shared();
+
+    WorkerPool();
+    ~WorkerPool();
+
+    /*
+     * Calls function(thread) for thread in [0, num_threads) concurrently and
+     * returns once all calls returned (a barrier). Thread 0 is the caller.
+     */
+    void run(const int num_threads,
+             const std::function<void(int)>& function);
+
+  protected:
+    void workerLoop(const int thread);
+
+    // Serializes jobs
+    std::mutex run_mutex_;
+
+    std::mutex mutex_;
+    std::condition_variable start_condition_;
+    std::condition_variable done_condition_;
+
+    std::vector<std::thread> workers_;
+
+    const std::function<void(int)>* job_;
+    int job_threads_;
+    unsigned int generation_;
+    int running_;
+    bool stop_;
+
+  private:
+    WorkerPool(const WorkerPool&);
+    WorkerPool& operator=(const WorkerPool&);
+  };
+
+  /*
+   * Splits [begin, end) into up to num_threads contiguous chunks and calls
+   * function(chunk_begin, chunk_end) for each on the shared pool.
+   */
+  template <typename Function>
+  void parallelFor(const int begin,
+                   const int end,
+                   const int num_threads,
+                   Function function)
+  {
+    int num_chunks = std::max(1, std::min(num_threads, end - begin));
+
+    if (num_chunks == 1){
+      function(begin, end);
+      return;
+    }
+
+    int chunk_size = (end - begin + num_chunks - 1) / num_chunks;
+
+    WorkerPool::shared().run(num_chunks, [&](int chunk){
+      int chunk_begin = begin + chunk * chunk_size;
+
+      if (chunk_begin < end)
+        function(chunk_begin, std::min(end, chunk_begin + chunk_size));
+    });
+  }
+
+} /* namespace */
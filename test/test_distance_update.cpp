@@ -0,0 +1,46 @@
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include "test_maps.h"
+
+using namespace grid_map_transforms;
+using namespace grid_map_proc_test;
+
+/*
+ * Random obstacles are added to and removed from the map in rounds, each
+ * round is repaired with updateDistanceTransform and compared to a full
+ * addDistanceTransform. Edits keep the reachable area connected (obstacles
+ * are only added in open space and only those are removed again), which
+ * updateDistanceTransform does not re-establish.
+ */
+TEST(DistanceUpdate, MatchesFullTransformUnderRandomEdits)
+{
+  const grid_map::Index seed_point (60, 40);
+
+  for (unsigned int seed = 1; seed <= 5; ++seed){
+    grid_map::GridMap grid_map (makeRandomMap(130, 97, 0.02, 0.01, seed, seed_point));
+    grid_map::Matrix& occupancy = grid_map["occupancy"];
+
+    std::vector<grid_map::Index> obstacle_cells, frontier_cells, changed_cells;
+    ASSERT_TRUE(addDistanceTransform(grid_map, seed_point, obstacle_cells, frontier_cells));
+
+    // Creates the previous occupancy copy
+    collectChangedOccupancyCells(grid_map, "occupancy_previous", changed_cells);
+
+    OccupancyCodes occupancy_codes;
+    std::vector<grid_map::Index> added_cells;
+    std::mt19937 rng (seed);
+
+    for (int round = 0; round < 8; ++round){
+      editOpenCells(occupancy, seed_point, 20, rng, added_cells);
+
+      ASSERT_TRUE(collectChangedOccupancyCells(grid_map, "occupancy_previous", changed_cells));
+      ASSERT_TRUE(updateDistanceTransform(grid_map, changed_cells, occupancy_codes));
+
+      grid_map::GridMap expected (grid_map);
+      ASSERT_TRUE(addDistanceTransform(expected, seed_point, obstacle_cells, frontier_cells));
+
+      SCOPED_TRACE(testing::Message() << "seed " << seed << " round " << round);
+      expectLayersNear(grid_map["distance_transform"], expected["distance_transform"], 1e-4f);
+    }
+  }
+}
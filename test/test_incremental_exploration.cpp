@@ -0,0 +1,66 @@
+#include <grid_map_proc/grid_map_exploration_transform.h>
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include "test_maps.h"
+
+using namespace grid_map_transforms;
+using namespace grid_map_proc_test;
+
+/*
+ * Goals are replaced and obstacles edited in rounds. The distance transform
+ * is repaired with updateDistanceTransform and the cells it changed are
+ * passed on, then IncrementalExplorationTransform::update is compared to a
+ * full addExplorationTransform of the same map and goals.
+ */
+TEST(IncrementalExplorationTransform, MatchesFullTransformUnderRandomEdits)
+{
+  const grid_map::Index seed_point (60, 40);
+
+  for (unsigned int seed = 1; seed <= 5; ++seed){
+    grid_map::GridMap grid_map (makeRandomMap(130, 97, 0.02, 0.01, seed, seed_point));
+    grid_map::Matrix& occupancy = grid_map["occupancy"];
+
+    std::vector<grid_map::Index> obstacle_cells, frontier_cells, changed_cells, changed_dist_cells;
+    ASSERT_TRUE(addDistanceTransform(grid_map, seed_point, obstacle_cells, frontier_cells));
+    ASSERT_GT(frontier_cells.size(), 10u);
+
+    collectChangedOccupancyCells(grid_map, "occupancy_previous", changed_cells);
+
+    std::mt19937 rng (seed);
+
+    std::vector<grid_map::Index> goal_points;
+
+    for (int i = 0; i < 5; ++i){
+      goal_points.push_back(frontier_cells[rng() % frontier_cells.size()]);
+    }
+
+    IncrementalExplorationTransform exploration_transform;
+    OccupancyCodes occupancy_codes;
+    std::vector<grid_map::Index> added_cells;
+
+    for (int round = 0; round < 8; ++round){
+      // The first round is the full computation
+      if (round > 0){
+        goal_points[rng() % goal_points.size()] = frontier_cells[rng() % frontier_cells.size()];
+
+        editOpenCells(occupancy, seed_point, 20, rng, added_cells);
+
+        ASSERT_TRUE(collectChangedOccupancyCells(grid_map, "occupancy_previous", changed_cells));
+        ASSERT_TRUE(updateDistanceTransform(grid_map, changed_cells, occupancy_codes,
+                                            "occupancy", "distance_transform", &changed_dist_cells));
+
+        exploration_transform.markCellsChanged(changed_cells);
+        exploration_transform.markCellsChanged(changed_dist_cells);
+      }
+
+      exploration_transform.setGoals(goal_points);
+      ASSERT_TRUE(exploration_transform.update(grid_map));
+
+      grid_map::GridMap expected (grid_map);
+      ASSERT_TRUE(addExplorationTransform(expected, goal_points));
+
+      SCOPED_TRACE(testing::Message() << "seed " << seed << " round " << round);
+      expectLayersNear(grid_map["exploration_transform"], expected["exploration_transform"], 1e-4f);
+    }
+  }
+}
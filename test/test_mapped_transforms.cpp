@@ -0,0 +1,158 @@
+#include <grid_map_proc/grid_map_mapped_transforms.h>
+#include <grid_map_proc/grid_map_transforms.h>
+
+#include "test_maps.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#include <unistd.h>
+
+using namespace grid_map_transforms;
+using namespace grid_map_proc_test;
+
+namespace{
+
+  // Unique file name, the file is removed again on destruction
+  struct TempFile
+  {
+    TempFile()
+    {
+      char name[] = "/tmp/grid_map_proc_test_XXXXXX";
+      const int fd = mkstemp(name);
+
+      if (fd >= 0)
+        ::close(fd);
+
+      file_name = name;
+    }
+
+    ~TempFile() { std::remove(file_name.c_str()); }
+
+    std::string file_name;
+  };
+
+  std::set<std::pair<int, int> > cellSet(const std::vector<grid_map::Index>& cells)
+  {
+    std::set<std::pair<int, int> > set;
+
+    for (size_t i = 0; i < cells.size(); ++i){
+      set.insert(std::make_pair(cells[i](0), cells[i](1)));
+    }
+
+    return set;
+  }
+
+  // Bitwise, so max and NaN cells compare equal to themselves
+  void expectLayersEqual(const grid_map::Matrix& actual,
+                         const grid_map::Matrix& expected)
+  {
+    ASSERT_EQ(expected.rows(), actual.rows());
+    ASSERT_EQ(expected.cols(), actual.cols());
+
+    for (int idx_y = 0; idx_y < expected.cols(); ++idx_y){
+      for (int idx_x = 0; idx_x < expected.rows(); ++idx_x){
+        EXPECT_EQ(0, std::memcmp(&actual(idx_x, idx_y), &expected(idx_x, idx_y), sizeof(float)))
+            << "at " << idx_x << " " << idx_y << ": " << actual(idx_x, idx_y) << " vs " << expected(idx_x, idx_y);
+      }
+    }
+  }
+
+}
+
+/*
+ * The mapped transforms run on a map whose size is not a multiple of the
+ * tile size, with few resident tiles so tiles are evicted and reloaded,
+ * and must reproduce the in core transforms bit for bit.
+ */
+TEST(MappedTransforms, MatchInCoreTransformsBitwise)
+{
+  const int size_x = 130;
+  const int size_y = 97;
+  const int max_resident_tiles = 2;
+  const grid_map::Index seed_point (60, 40);
+
+  for (unsigned int seed = 1; seed <= 3; ++seed){
+    SCOPED_TRACE(testing::Message() << "seed " << seed);
+
+    grid_map::GridMap grid_map (makeRandomMap(size_x, size_y, 0.03, 0.01, seed, seed_point));
+
+    std::vector<grid_map::Index> obstacle_cells, frontier_cells;
+    ASSERT_TRUE(addDistanceTransform(grid_map, seed_point, obstacle_cells, frontier_cells));
+    ASSERT_FALSE(frontier_cells.empty());
+
+    std::vector<grid_map::Index> goal_points (frontier_cells.begin(), frontier_cells.begin() + std::min<size_t>(5, frontier_cells.size()));
+    ASSERT_TRUE(addExplorationTransform(grid_map, goal_points));
+
+    TempFile occupancy_file, codes_file, state_file, dist_file, expl_file;
+    MappedTiledGrid<float> occupancy, dist_trans, expl_trans;
+    MappedTiledGrid<unsigned char> occupancy_codes, cell_state;
+
+    ASSERT_TRUE(occupancy.create(occupancy_file.file_name, size_x, size_y));
+    ASSERT_TRUE(occupancy_codes.create(codes_file.file_name, size_x, size_y));
+    ASSERT_TRUE(cell_state.create(state_file.file_name, size_x, size_y));
+    ASSERT_TRUE(dist_trans.create(dist_file.file_name, size_x, size_y));
+    ASSERT_TRUE(expl_trans.create(expl_file.file_name, size_x, size_y));
+
+    ASSERT_TRUE(importMappedLayer(grid_map["occupancy"], grid_map.getStartIndex(), occupancy));
+    ASSERT_TRUE(buildMappedOccupancyCodes(occupancy, occupancy_codes));
+
+    std::vector<grid_map::Index> mapped_obstacle_cells, mapped_frontier_cells;
+    ASSERT_TRUE(computeDistanceTransformMapped(occupancy_codes, seed_point, mapped_obstacle_cells, mapped_frontier_cells,
+                                               cell_state, dist_trans, max_resident_tiles));
+    ASSERT_TRUE(computeExplorationTransformMapped(occupancy_codes, dist_trans, goal_points, expl_trans,
+                                                  6.0, 12.0, max_resident_tiles));
+
+    EXPECT_TRUE(cellSet(mapped_obstacle_cells) == cellSet(obstacle_cells));
+    EXPECT_TRUE(cellSet(mapped_frontier_cells) == cellSet(frontier_cells));
+
+    grid_map::Matrix layer;
+
+    ASSERT_TRUE(exportMappedLayer(dist_trans, grid_map.getStartIndex(), layer));
+    expectLayersEqual(layer, grid_map["distance_transform"]);
+
+    ASSERT_TRUE(exportMappedLayer(expl_trans, grid_map.getStartIndex(), layer));
+    expectLayersEqual(layer, grid_map["exploration_transform"]);
+  }
+}
+
+// Layers of moved maps are unwrapped into the tiled grid and wrapped again
+TEST(MappedTransforms, ImportExportMovedLayer)
+{
+  const int size_x = 130;
+  const int size_y = 97;
+
+  grid_map::Matrix layer (size_x, size_y);
+
+  for (int i = 0; i < layer.size(); ++i){
+    layer.data()[i] = static_cast<float>(i);
+  }
+
+  const grid_map::Index start_indices[] = { grid_map::Index(0, 0), grid_map::Index(1, 0), grid_map::Index(70, 3),
+                                            grid_map::Index(size_x - 1, size_y - 1) };
+
+  for (size_t i = 0; i < sizeof(start_indices) / sizeof(start_indices[0]); ++i){
+    const grid_map::Index& start_index = start_indices[i];
+    SCOPED_TRACE(testing::Message() << "start index " << start_index(0) << " " << start_index(1));
+
+    TempFile file;
+    MappedTiledGrid<float> grid;
+    ASSERT_TRUE(grid.create(file.file_name, size_x, size_y));
+    ASSERT_TRUE(importMappedLayer(layer, start_index, grid));
+
+    grid_map::Index buffer_index;
+
+    for (int idx_y = 0; idx_y < size_y; ++idx_y){
+      for (int idx_x = 0; idx_x < size_x; ++idx_x){
+        buffer_index = grid_map::getBufferIndexFromIndex(grid_map::Index(idx_x, idx_y), grid_map::Size(size_x, size_y), start_index);
+        EXPECT_EQ(layer(buffer_index(0), buffer_index(1)), grid.at(idx_x, idx_y));
+      }
+    }
+
+    grid_map::Matrix exported;
+    ASSERT_TRUE(exportMappedLayer(grid, start_index, exported));
+    expectLayersEqual(exported, layer);
+  }
+}
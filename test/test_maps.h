@@ -0,0 +1,127 @@
+#pragma once
+
+// Grid Map
+#include <grid_map_ros/grid_map_ros.hpp>
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <random>
+
+namespace grid_map_proc_test{
+
+  /*
+   * size_x by size_y map with an occupancy layer in which cells are
+   * occupied (100) with probability p_occupied, unknown (NaN) with
+   * probability p_unknown and free (0) otherwise. Free start_cell is
+   * the seed of the transforms.
+   */
+  inline grid_map::GridMap makeRandomMap(const int size_x,
+                                         const int size_y,
+                                         const double p_occupied,
+                                         const double p_unknown,
+                                         const unsigned int seed,
+                                         const grid_map::Index& start_cell)
+  {
+    grid_map::GridMap grid_map (std::vector<std::string>(1, "occupancy"));
+    grid_map.setGeometry(grid_map::Length(size_x * 0.05, size_y * 0.05), 0.05);
+
+    std::mt19937 rng (seed);
+    std::uniform_real_distribution<double> uniform (0.0, 1.0);
+
+    grid_map::Matrix& occupancy = grid_map["occupancy"];
+
+    for (int idx_y = 0; idx_y < size_y; ++idx_y){
+      for (int idx_x = 0; idx_x < size_x; ++idx_x){
+        const double sample = uniform(rng);
+
+        if (sample < p_occupied)
+          occupancy(idx_x, idx_y) = 100.0f;
+        else if (sample < p_occupied + p_unknown)
+          occupancy(idx_x, idx_y) = std::numeric_limits<float>::quiet_NaN();
+        else
+          occupancy(idx_x, idx_y) = 0.0f;
+      }
+    }
+
+    occupancy(start_cell(0), start_cell(1)) = 0.0f;
+
+    return grid_map;
+  }
+
+  // Free cell off the map edge with only free neighbors
+  inline bool isOpenCell(const grid_map::Matrix& occupancy,
+                         const int idx_x,
+                         const int idx_y)
+  {
+    if ((idx_x < 1) || (idx_y < 1) || (idx_x >= occupancy.rows() - 1) || (idx_y >= occupancy.cols() - 1))
+      return false;
+
+    for (int dy = -1; dy <= 1; ++dy){
+      for (int dx = -1; dx <= 1; ++dx){
+        if (occupancy(idx_x + dx, idx_y + dy) != 0.0f)
+          return false;
+      }
+    }
+
+    return true;
+  }
+
+  /*
+   * Random edits that keep the free space connected: obstacles are only
+   * added at open cells (isOpenCell) other than keep_free, and only those
+   * (kept in added_cells) are removed again.
+   */
+  inline void editOpenCells(grid_map::Matrix& occupancy,
+                            const grid_map::Index& keep_free,
+                            const int num_edits,
+                            std::mt19937& rng,
+                            std::vector<grid_map::Index>& added_cells)
+  {
+    for (int edit = 0; edit < num_edits; ++edit){
+      if (!added_cells.empty() && (rng() % 3 == 0)){
+        const size_t i = rng() % added_cells.size();
+        occupancy(added_cells[i](0), added_cells[i](1)) = 0.0f;
+        added_cells.erase(added_cells.begin() + i);
+        continue;
+      }
+
+      const int idx_x = rng() % occupancy.rows();
+      const int idx_y = rng() % occupancy.cols();
+
+      if ((grid_map::Index(idx_x, idx_y) != keep_free).any() && isOpenCell(occupancy, idx_x, idx_y)){
+        occupancy(idx_x, idx_y) = 100.0f;
+        added_cells.push_back(grid_map::Index(idx_x, idx_y));
+      }
+    }
+  }
+
+  /*
+   * Expects the same cells at std::numeric_limits<float>::max() (not
+   * reached) in both layers and the other values within tolerance, relative
+   * to the expected value above 1.
+   */
+  inline void expectLayersNear(const grid_map::Matrix& actual,
+                               const grid_map::Matrix& expected,
+                               const float tolerance)
+  {
+    ASSERT_EQ(expected.rows(), actual.rows());
+    ASSERT_EQ(expected.cols(), actual.cols());
+
+    const float max_val = std::numeric_limits<float>::max();
+
+    for (int idx_y = 0; idx_y < expected.cols(); ++idx_y){
+      for (int idx_x = 0; idx_x < expected.rows(); ++idx_x){
+        const float a = actual(idx_x, idx_y);
+        const float b = expected(idx_x, idx_y);
+
+        if ((a == max_val) || (b == max_val))
+          EXPECT_EQ(b, a) << "at " << idx_x << " " << idx_y;
+        else
+          EXPECT_NEAR(b, a, tolerance * std::max(1.0f, std::abs(b))) << "at " << idx_x << " " << idx_y;
+      }
+    }
+  }
+
+} /* namespace */